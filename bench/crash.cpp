@@ -0,0 +1,227 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// 
+// Locker (C++ Library)
+// Copyright (C) 2020 Jean "Jango" Diogo <jeandiogo@gmail.com>
+// 
+// Licensed under the Apache License Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// You may obtain a copy of the License at <http://www.apache.org/licenses/LICENSE-2.0>.
+// 
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and limitations under the License.
+// 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// 
+// bench/crash.cpp
+// 
+// Kills lock holders with SIGKILL at random points (inside locker::lock, between fsync and unlink inside locker::release, and anywhere in the critical section),
+// then measures how long the surviving waiters take to get the lock, whether mutual exclusion was ever lost, and what was left behind, for each backend.
+// 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+void fault(char const * point);
+
+#define LOCKER_FAULT_POINT(point) fault(point)
+#define LOCKER_NUMA_NODE(node) (static_cast<unsigned>(::getpid()) % 2)
+
+#include "../locker.hpp"
+
+#define NUM_WORKERS 8
+#define NUM_SECONDS 2
+#define FAULT_ODDS 500
+
+struct shared_t
+{
+	std::atomic<bool> stop;
+	std::atomic<::pid_t> owner;
+	std::atomic<std::int64_t> killed_at;
+	std::atomic<std::uint64_t> acquisitions;
+	std::atomic<std::uint64_t> lock_kills;
+	std::atomic<std::uint64_t> release_kills;
+	std::atomic<std::uint64_t> holder_kills;
+	std::atomic<std::uint64_t> recoveries;
+	std::atomic<std::int64_t> recovery_total;
+	std::atomic<std::int64_t> recovery_max;
+	std::atomic<std::uint64_t> violations;
+};
+
+static shared_t * shared = nullptr;
+static bool is_worker = false;
+
+static auto now()
+{
+	return static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static auto is_running(::pid_t const pid)
+{
+	auto stat = std::ifstream("/proc/" + std::to_string(pid) + "/stat");
+	auto line = std::string();
+	std::getline(stat, line);
+	auto const position = line.rfind(')');
+	return position != std::string::npos and position + 2 < line.size() and line[position + 2] != 'Z' and line[position + 2] != 'X';
+}
+
+void fault(char const * point)
+{
+	if(is_worker and std::rand() % FAULT_ODDS == 0)
+	{
+		(std::strcmp(point, "lock") == 0 ? shared->lock_kills : shared->release_kills).fetch_add(1);
+		shared->killed_at.store(now());
+		::kill(::getpid(), SIGKILL);
+	}
+}
+
+template <typename acquire_t>
+static void work(acquire_t const & acquire)
+{
+	is_worker = true;
+	std::srand(static_cast<unsigned>(::getpid()));
+	auto const pid = ::getpid();
+	while(!shared->stop.load())
+	{
+		auto const guard = acquire();
+		auto const previous = shared->owner.exchange(pid);
+		if(previous != 0 and is_running(previous))
+		{
+			shared->violations.fetch_add(1);
+		}
+		auto const killed_at = shared->killed_at.exchange(0);
+		if(killed_at != 0)
+		{
+			auto const recovery = now() - killed_at;
+			shared->recoveries.fetch_add(1);
+			shared->recovery_total.fetch_add(recovery);
+			auto maximum = shared->recovery_max.load();
+			while(recovery > maximum and !shared->recovery_max.compare_exchange_weak(maximum, recovery));
+		}
+		shared->acquisitions.fetch_add(1);
+		std::this_thread::sleep_for(std::chrono::microseconds(std::rand() % 100));
+		auto expected = pid;
+		shared->owner.compare_exchange_strong(expected, 0);
+	}
+}
+
+template <typename acquire_t>
+static void run(std::string const & backend, std::vector<std::string> const & filenames, acquire_t const & acquire)
+{
+	std::memset(static_cast<void *>(shared), 0, sizeof(shared_t));
+	auto const spawn = [&]()
+	{
+		auto const pid = ::fork();
+		if(pid < 0)
+		{
+			throw std::runtime_error("fork did not work");
+		}
+		else if(pid == 0)
+		{
+			work(acquire);
+			std::exit(EXIT_SUCCESS);
+		}
+	};
+	for(std::size_t i = 0; i < NUM_WORKERS; ++i)
+	{
+		spawn();
+	}
+	auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(NUM_SECONDS);
+	while(std::chrono::steady_clock::now() < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1 + std::rand() % 10));
+		auto victim = shared->owner.load();
+		if(victim != 0 and shared->owner.compare_exchange_strong(victim, 0))
+		{
+			shared->killed_at.store(now());
+			shared->holder_kills.fetch_add(1);
+			::kill(victim, SIGKILL);
+		}
+		int status = 0;
+		while(::waitpid(-1, &status, WNOHANG) > 0)
+		{
+			if(WIFSIGNALED(status))
+			{
+				spawn();
+			}
+		}
+	}
+	shared->stop.store(true);
+	int status = 0;
+	while(::wait(&status) > 0);
+	auto const kills = shared->lock_kills.load() + shared->release_kills.load() + shared->holder_kills.load();
+	auto const recoveries = shared->recoveries.load();
+	auto const mean = recoveries ? static_cast<double>(shared->recovery_total.load()) / static_cast<double>(recoveries) / 1000.0 : 0.0;
+	std::cout << backend << ":\n";
+	std::cout << "  acquisitions:   " << shared->acquisitions.load() << "\n";
+	std::cout << "  kills:          " << kills << " (" << shared->lock_kills.load() << " in lock, " << shared->release_kills.load() << " in release, " << shared->holder_kills.load() << " while holding)\n";
+	std::cout << "  recovery:       " << mean << "us mean, " << static_cast<double>(shared->recovery_max.load()) / 1000.0 << "us max over " << recoveries << " recoveries\n";
+	std::cout << "  violations:     " << shared->violations.load() << "\n";
+	auto leaked = std::string();
+	for(auto const & filename : filenames)
+	{
+		if(std::filesystem::exists(filename))
+		{
+			leaked += (leaked.empty() ? "" : ", ") + filename;
+		}
+	}
+	std::cout << "  leaked files:   " << (leaked.empty() ? "none" : leaked) << std::endl;
+}
+
+int main()
+{
+	shared = static_cast<shared_t *>(::mmap(nullptr, sizeof(shared_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+	if(shared == MAP_FAILED)
+	{
+		throw std::runtime_error("mmap did not work");
+	}
+	std::cout << "killing holders of " << NUM_WORKERS << " workers for " << NUM_SECONDS << "s per backend:" << std::endl;
+	
+	run("lock_guard", {"crash.lock"}, []()
+	{
+		return locker::lock_guard("crash.lock");
+	});
+	
+	run("priority_lock_guard", {"crash.priority.lock"}, []()
+	{
+		return locker::priority_lock_guard("crash.priority.lock", std::rand() % 10);
+	});
+	
+	std::ofstream("crash.cohort.lock") << "anchor";
+	struct ::stat status;
+	if(::stat("crash.cohort.lock", &status) < 0)
+	{
+		throw std::runtime_error("stat did not work");
+	}
+	auto const name = "/dev/shm/locker." + std::to_string(status.st_dev) + "." + std::to_string(status.st_ino) + ".cohort";
+	auto const cohort_files = std::vector<std::string>{name, name + ".0", name + ".1"};
+	run("cohort_guard (2 nodes)", cohort_files, []()
+	{
+		return locker::cohort_guard("crash.cohort.lock");
+	});
+	for(auto const & filename : cohort_files)
+	{
+		std::filesystem::remove(filename);
+	}
+	std::filesystem::remove("crash.cohort.lock");
+	
+	return EXIT_SUCCESS;
+}
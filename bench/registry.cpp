@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// 
+// Locker (C++ Library)
+// Copyright (C) 2020 Jean "Jango" Diogo <jeandiogo@gmail.com>
+// 
+// Licensed under the Apache License Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// You may obtain a copy of the License at <http://www.apache.org/licenses/LICENSE-2.0>.
+// 
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and limitations under the License.
+// 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// 
+// bench/registry.cpp
+// 
+// Fills the registry of held lockfiles with 1 to 1,000,000 keys (bounded by the descriptor limit, since every held key keeps a descriptor open),
+// then measures the cost of a fresh lock, a reentrant lock and an unlock with 1 to 64 threads.
+// Lockfiles live in /dev/shm, so the file operations stay on tmpfs and the numbers are dominated by the registry and its mutex.
+// 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../locker.hpp"
+
+#define MAX_KEYS 1000000
+#define MAX_THREADS 64
+#define NUM_OPERATIONS 4096
+
+static auto const directory = "/dev/shm/locker.registry." + std::to_string(::getpid());
+
+static auto get_filename(std::size_t const i)
+{
+	return directory + "/" + std::to_string(i) + ".lock";
+}
+
+int main()
+{
+	auto limit = ::rlimit();
+	::getrlimit(RLIMIT_NOFILE, &limit);
+	limit.rlim_cur = limit.rlim_max;
+	::setrlimit(RLIMIT_NOFILE, &limit);
+	auto const max_keys = std::min<std::size_t>(MAX_KEYS, static_cast<std::size_t>(limit.rlim_cur) - 2 * MAX_THREADS - 64);
+	std::filesystem::create_directories(directory);
+	std::cout << "registry scaling over held keys and threads (ns per operation, " << NUM_OPERATIONS << " operations per cell, at most " << max_keys << " keys under the descriptor limit):" << std::endl;
+	std::cout << std::setw(10) << "keys" << std::setw(10) << "threads" << std::setw(12) << "lock" << std::setw(12) << "reentrant" << std::setw(12) << "unlock" << std::endl;
+	
+	auto sizes = std::vector<std::size_t>();
+	for(std::size_t num_keys = 1; num_keys < max_keys; num_keys *= 10)
+	{
+		sizes.push_back(num_keys);
+	}
+	sizes.push_back(max_keys);
+	
+	auto held = std::deque<locker::lock_guard_t<>>();
+	for(auto const num_keys : sizes)
+	{
+		while(held.size() < num_keys)
+		{
+			held.emplace_back(get_filename(held.size()));
+		}
+		for(std::size_t num_threads = 1; num_threads <= MAX_THREADS; num_threads *= 4)
+		{
+			auto lock_time = std::chrono::nanoseconds(0);
+			auto reentrant_time = std::chrono::nanoseconds(0);
+			auto unlock_time = std::chrono::nanoseconds(0);
+			auto mutex = std::mutex();
+			auto threads = std::vector<std::jthread>();
+			for(std::size_t t = 0; t < num_threads; ++t)
+			{
+				threads.emplace_back([&, t]()
+				{
+					auto const fresh = get_filename(max_keys + t);
+					auto const reentrant = get_filename((t * 7919) % num_keys);
+					auto fresh_guard = std::optional<locker::lock_guard_t<>>();
+					auto reentrant_guard = std::optional<locker::lock_guard_t<>>();
+					auto local_lock = std::chrono::nanoseconds(0);
+					auto local_reentrant = std::chrono::nanoseconds(0);
+					auto local_unlock = std::chrono::nanoseconds(0);
+					for(std::size_t i = 0; i < NUM_OPERATIONS / num_threads; ++i)
+					{
+						auto const start = std::chrono::steady_clock::now();
+						fresh_guard.emplace(fresh);
+						auto const locked = std::chrono::steady_clock::now();
+						reentrant_guard.emplace(reentrant);
+						auto const relocked = std::chrono::steady_clock::now();
+						reentrant_guard.reset();
+						fresh_guard.reset();
+						auto const unlocked = std::chrono::steady_clock::now();
+						local_lock += locked - start;
+						local_reentrant += relocked - locked;
+						local_unlock += unlocked - relocked;
+					}
+					auto const guard = std::scoped_lock<std::mutex>(mutex);
+					lock_time += local_lock;
+					reentrant_time += local_reentrant;
+					unlock_time += local_unlock;
+				});
+			}
+			threads.clear();
+			auto const num_operations = static_cast<double>((NUM_OPERATIONS / num_threads) * num_threads);
+			std::cout << std::setw(10) << num_keys << std::setw(10) << num_threads << std::fixed << std::setprecision(0);
+			std::cout << std::setw(12) << static_cast<double>(lock_time.count()) / num_operations;
+			std::cout << std::setw(12) << static_cast<double>(reentrant_time.count()) / num_operations;
+			std::cout << std::setw(12) << static_cast<double>(unlock_time.count()) / num_operations << std::endl;
+		}
+	}
+	held.clear();
+	std::filesystem::remove_all(directory);
+	return EXIT_SUCCESS;
+}
@@ -20,7 +20,10 @@
 // The locker provides process-safety but not thread-safety. Once a process has acquired the lock, its threads and future forks will not be stopped by it.
 // If the lockfile does not exist at lock, it will be created. If the lockfile is empty during unlock, it will be erased.
 // An exception will be thrown if the given filename refers to a file which existis but is not regular, or if its directory is not authorized for writing.
-// When compiling with g++ use the flag "-std=c++20" (available in GCC 10 or later).
+// When compiling with g++ use the flag "-std=c++20" (available in GCC 10 or later). The header needs Linux 5.11 uapi headers (for IORING_OP_UNLINKAT) and glibc 2.28 (for statx); newer kernel features are defined locally and fall back to plain syscalls at runtime.
+// Read caches are told of writers by the real-time signal LOCKER_LEASE_SIGNAL (default SIGRTMIN + 1), whose handler is installed only if the signal has no handler yet.
+// Defining the macro LOCKER_NUMA_NODE(node) before including this header overrides the node a cohort guard queues on (by default the node of the current CPU), which is how tests put processes on different nodes.
+// Defining the macro LOCKER_FAULT_POINT(point) before including this header hooks the points "lock" (right after flock) and "release" (between fsync and unlink), which is how bench/crash.cpp kills holders there.
 // 
 // Usage:
 // 
@@ -28,22 +31,61 @@
 // 
 // locker::lock_guard_t my_lock = locker::lock_guard("a.lock");              //locks a file and automatically unlocks it before leaving current scope (an empty lockfile will be created if it does not exist)
 // locker::lock_guard_t my_lock = locker::lock_guard<true>("a.lock");        //use first template argument to make it "non-blocking" (i.e. will throw instead of wait if file is already locked)
+// std::size_t const sent = my_lock.send(socket, offset, count);             //sends the locked file to a socket, pipe or file (with sendfile, splice or copy_file_range) through the descriptor opened by the lock
+// locker::batch_guard_t my_lock = locker::batch_lock_guard({"a.lock", "b.lock"}); //locks many files in name order, opening, checking, syncing, erasing and closing them in a few io_uring submissions (or plain syscalls without io_uring)
+// locker::lock_guard_t my_lock = locker::lock_guard("a.lock", {.filename = "a.dat"}); //if the lock is busy, asks the kernel to read "a.dat" ahead (or a range with ".offset" and ".length", or a mapping with ".address" and ".size") while waiting
+// locker::lock_guard_t my_lock = locker::lock_with_backoff("a.lock", {.max_attempts = 10}); //retries a non-blocking lock with jittered exponential backoff (also ".initial", ".maximum", ".deadline", ".should_use_profile" or any callable (attempt, filename) returning an optional delay), throwing only once it gives up
+// for(auto const & filename : locker::lock_chain({"a.lock", "b.lock"})) {} //walks the files in the given order holding at most two locks, taking the next one before releasing the previous one (hand-over-hand)
+// locker::lock_guard_t my_lock = locker::directory_lock_guard("a.dir");     //locks an existing directory itself, opened read-only, without creating, syncing or erasing anything ("<true>" makes it non-blocking)
+// locker::lock_guard_t my_lock = locker::shared_lock_guard("a.lock");       //shared lock, held with other shared locks but not with exclusive ones (a shared lockfile is never erased at unlock)
+// locker::lock_guard_t my_lock = locker::priority_lock_guard("a.lock", 10); //waits in a queue shared through "/dev/shm", where higher priorities go first and every 100ms waited is worth one priority level
+// locker::cohort_guard_t my_lock = locker::cohort_guard("a.lock");          //NUMA-aware lock kept in "/dev/shm", passed among processes of the same node before crossing to another node (excludes only other cohort guards)
+// locker::set_teardown(locker::teardown_t::close_only);                     //at exit and at "locker::release_all()", closes descriptors in bulk with close_range ("syncfs_once" adds one syncfs per device, "fsync_each" is the default fsync of every lockfile)
+// locker::set_estimating(true);                                            //from now on, blocking and non-blocking guards share their waiter counts and hold times in "/dev/shm", keyed by a hash of the lockfile path
+// auto const my_wait = locker::estimate_wait("a.lock");                     //estimates how long a lock would take from its holder's expected remaining time plus one average hold time per waiter (zero if never measured)
+// locker::set_profiling(true);                                              //from now on, guards count time, instructions, cycles, cache misses, context switches and page faults spent while holding each lock
+// auto const my_profile = locker::get_profile("a.lock");                    //returns the counters accumulated for a lockfile (hardware counters stay at zero when the PMU is unavailable)
+// bool const is_called = locker::call_once("a.once", my_function);          //calls my_function once across processes, under the lock of "a.once", which is then marked non-empty so later calls return after a single stat
+// std::string const result = locker::single_flight("a.txt", my_compute);    //returns the contents of "a.txt", or computes them with my_compute() under "a.txt.flight" while concurrent callers wait for that flight and reuse its result
+// bool const is_unlocked = locker::wait_unlocked("a.lock", 100ms);          //waits until no process holds the lock, without taking it (returns false at timeout, which is infinite by default)
+// locker::read_cache_t my_cache = locker::read_cache("a.txt");              //caches the contents of a file under a read lease, so "my_cache.get()" re-reads it under the lock only after a writer has opened it
+// locker::queue_t my_queue = locker::queue<int, 1024>("a.queue");           //bounded inter-process queue of trivially copyable elements mapped from a file, with "push", "pop" (blocking), "try_push" and "try_pop"
+// locker::rate_limiter_t my_limiter = locker::rate_limiter("a.rate", 100, 10); //allows 100 permits per second in bursts of up to 10 across processes, with "try_acquire(count)" and "acquire(count)" (sleeps until its permits are due)
+// locker::keyed_t my_keys = locker::keyed("a.keys"); auto const lock = my_keys.lock("k"); //locks a key on one of the futex stripes in "/dev/shm", where stripes contended by different keys are split online and a thread re-enters a stripe it already holds ("lock<true>" throws if busy)
+// locker::keyed_t::async_t my_waiter = my_keys.async(); my_waiter.lock("k", my_callback); my_waiter.run(); //one thread waits on many keys at once (io_uring futex waits, else futex_waitv, else futex) and runs each callback under its key's lock
+// locker::epoch_t my_epoch = locker::epoch("a.index"); auto const reader = my_epoch.read(); //lock-free read section, while writers "retire(callback)" unlinked nodes and "reclaim()" runs callbacks once no earlier reader remains ("synchronize()" only waits)
+// locker::appender_t my_log = locker::appender("a.log", {.max_records = 64}); //"my_log.append(record)" is one O_APPEND write without locking, synced by fdatasync every 64 records (or at the first append after ".max_delay"), while "rotate(target)" and "truncate()" take the lock
+// locker::snapshot_t my_snapshot = locker::snapshot("a.txt");              //"my_snapshot.publish(writer)" writes "a.txt.<n>" through writer(filename) and points "a.txt" at it, "my_snapshot.pin()" keeps a version under a shared lock
+// locker::arena_t my_arena("a.arena"); auto const lock = my_arena.lock();   //allocator over a mapped file, used under its lock through offsets ("allocate", "deallocate", "get", "get_root", "set_root", "vector_t", "string_t")
 // 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #ifndef LOCKER_HPP
 #define LOCKER_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
+#include <functional>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <random>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -51,6 +93,18 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/file.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <linux/futex.h>
+#include <linux/io_uring.h>
+#include <linux/perf_event.h>
+#include <linux/time_types.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
 #include <unistd.h>
 #include <fcntl.h>
 
@@ -58,6 +112,18 @@
 	#define PATH_MAX 4096
 #endif
 
+#ifndef LOCKER_FAULT_POINT
+	#define LOCKER_FAULT_POINT(point)
+#endif
+
+#ifndef LOCKER_NUMA_NODE
+	#define LOCKER_NUMA_NODE(node) (node)
+#endif
+
+#ifndef LOCKER_LEASE_SIGNAL
+	#define LOCKER_LEASE_SIGNAL (SIGRTMIN + 1)
+#endif
+
 class locker
 {
 	struct key_t
@@ -92,11 +158,31 @@ class locker
 		}
 	};
 	
+	static constexpr std::size_t max_stats_processes = 256;
+	
+	struct stats_slot_t
+	{
+		std::atomic<std::uint32_t> pid;
+		std::atomic<std::uint32_t> waiters;
+		std::atomic<std::uint32_t> holders;
+		std::atomic<std::int64_t> acquired_at;
+	};
+	
+	struct stats_t
+	{
+		std::atomic<std::int64_t> hold_time;
+		stats_slot_t slots[max_stats_processes];
+	};
+	
 	struct value_t
 	{
 		int descriptor = -1;
 		int num_locks = 0;
 		::pid_t pid = -1;
+		bool is_shared = false;
+		stats_t * stats = nullptr;
+		stats_slot_t * stats_slot = nullptr;
+		std::uint64_t generation = 0;
 		
 		value_t() = default;
 		value_t(value_t const & other) = default;
@@ -104,7 +190,7 @@ class locker
 		value_t & operator=(value_t const & other) = default;
 		value_t & operator=(value_t && other) = default;
 		
-		value_t(int const _descriptor, int const _num_locks, ::pid_t const _pid) : descriptor(_descriptor), num_locks(_num_locks), pid(_pid)
+		value_t(int const _descriptor, int const _num_locks, ::pid_t const _pid, bool const _is_shared = false) : descriptor(_descriptor), num_locks(_num_locks), pid(_pid), is_shared(_is_shared)
 		{
 		}
 		
@@ -113,11 +199,43 @@ class locker
 			descriptor = -1;
 			num_locks = 0;
 			pid = -1;
+			is_shared = false;
+			stats = nullptr;
+			stats_slot = nullptr;
+			generation = 0;
 		}
 	};
 	
+	struct profile_t
+	{
+		std::uint64_t holds = 0;
+		std::uint64_t nanoseconds = 0;
+		std::uint64_t instructions = 0;
+		std::uint64_t cycles = 0;
+		std::uint64_t cache_misses = 0;
+		std::uint64_t context_switches = 0;
+		std::uint64_t page_faults = 0;
+		std::uint64_t task_clock = 0;
+	};
+	
+	struct prefetch_t
+	{
+		std::string filename;
+		::off_t offset = 0;
+		::off_t length = 0;
+		void const * address = nullptr;
+		std::size_t size = 0;
+	};
+	
 	std::mutex mtx;
 	std::map<key_t, value_t> lockfiles;
+	std::uint64_t generation = 0;
+	std::map<std::string, profile_t> profiles;
+	std::atomic<bool> is_profiling = false;
+	std::atomic<int> teardown = 0;
+	std::atomic<bool> is_estimating = false;
+	std::mutex flight_mtx;
+	std::map<std::string, std::shared_ptr<std::mutex>> flights;
 	
 	static auto & get_singleton()
 	{
@@ -125,16 +243,366 @@ class locker
 		return singleton;
 	}
 	
-	template <bool should_not_block>
-	static inline auto lock(std::string const & filename)
+	static inline auto get_normal_path(std::string const & filename)
 	{
-		auto & singleton = get_singleton();
-		auto const guard = std::scoped_lock<std::mutex>(singleton.mtx);
+		return std::filesystem::absolute(filename).lexically_normal().string();
+	}
+	
+	struct directory_t
+	{
+	};
+	
+	struct backoff_t
+	{
+		std::chrono::nanoseconds initial = std::chrono::microseconds(10);
+		std::chrono::nanoseconds maximum = std::chrono::milliseconds(10);
+		std::size_t max_attempts = SIZE_MAX;
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+		bool should_use_profile = false;
+		
+		auto operator()(std::size_t const attempt, std::string const & filename) const -> std::optional<std::chrono::nanoseconds>
+		{
+			if(attempt + 1 >= max_attempts)
+			{
+				return std::nullopt;
+			}
+			auto base = initial;
+			if(should_use_profile)
+			{
+				auto & singleton = get_singleton();
+				auto const guard = std::scoped_lock<std::mutex>(singleton.mtx);
+				if(auto const profile = singleton.profiles.find(get_normal_path(filename)); profile != singleton.profiles.end() and profile->second.holds > 0)
+				{
+					base = std::max(base, std::chrono::nanoseconds(profile->second.nanoseconds / profile->second.holds));
+				}
+			}
+			thread_local auto engine = std::minstd_rand(static_cast<std::uint32_t>(::getpid()) ^ static_cast<std::uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+			auto const ceiling = static_cast<double>(std::min(maximum, base * (std::int64_t(1) << std::min<std::size_t>(attempt, 30))).count());
+			auto delay = std::chrono::nanoseconds(static_cast<std::int64_t>(std::uniform_real_distribution<double>(ceiling / 2, ceiling)(engine)));
+			if(deadline != std::chrono::steady_clock::time_point::max())
+			{
+				auto const remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now());
+				if(remaining.count() <= 0)
+				{
+					return std::nullopt;
+				}
+				delay = std::min(delay, remaining);
+			}
+			return delay;
+		}
+	};
+	
+	class mapping_t
+	{
+		int descriptor = -1;
+		void * address = nullptr;
+		std::size_t length = 0;
+		
+		public:
+		
+		mapping_t(mapping_t const &) = delete;
+		mapping_t(mapping_t &&) = delete;
+		mapping_t & operator=(mapping_t const &) = delete;
+		mapping_t & operator=(mapping_t &&) = delete;
+		
+		mapping_t(std::string const & filename, std::size_t const size)
+		{
+			::mode_t mask = ::umask(0);
+			descriptor = ::open(filename.c_str(), O_RDWR | O_CREAT, 0666);
+			::umask(mask);
+			if(descriptor < 0)
+			{
+				throw std::runtime_error("could not open file \"" + filename + "\" for mapping");
+			}
+			struct ::stat status;
+			if(::fstat(descriptor, &status) < 0 or (static_cast<std::size_t>(status.st_size) < size and ::ftruncate(descriptor, static_cast<::off_t>(size)) < 0))
+			{
+				::close(descriptor);
+				throw std::runtime_error("could not resize file \"" + filename + "\" for mapping");
+			}
+			address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+			if(address == MAP_FAILED)
+			{
+				::close(descriptor);
+				throw std::runtime_error("could not map file \"" + filename + "\"");
+			}
+			length = size;
+		}
+		
+		~mapping_t()
+		{
+			::munmap(address, length);
+			::close(descriptor);
+		}
+		
+		template <typename type_t>
+		auto get(std::size_t const offset = 0) const
+		{
+			return static_cast<type_t *>(static_cast<void *>(static_cast<char *>(address) + offset));
+		}
+	};
+	
+	std::mutex mapping_mtx;
+	std::map<std::string, std::unique_ptr<mapping_t>> mappings;
+	
+	static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t) and std::atomic<std::uint32_t>::is_always_lock_free);
+	
+	static inline auto futex_wait(std::atomic<std::uint32_t> & word, std::uint32_t const expected, std::chrono::nanoseconds const timeout)
+	{
+		auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+		auto const spec = ::timespec{static_cast<::time_t>(seconds.count()), static_cast<long>((timeout - seconds).count())};
+		return ::syscall(SYS_futex, &word, FUTEX_WAIT, expected, &spec, nullptr, 0) == 0;
+	}
+	
+	static inline auto futex_wake(std::atomic<std::uint32_t> & word, int const count = INT_MAX)
+	{
+		::syscall(SYS_futex, &word, FUTEX_WAKE, count, nullptr, nullptr, 0);
+	}
+	
+	static inline auto is_alive(::pid_t const pid)
+	{
+		if(::kill(pid, 0) < 0)
+		{
+			return errno != ESRCH;
+		}
+		auto const path = "/proc/" + std::to_string(pid) + "/stat";
+		auto const descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if(descriptor < 0)
+		{
+			return true;
+		}
+		char line[512];
+		auto const size = ::read(descriptor, line, sizeof(line) - 1);
+		::close(descriptor);
+		if(size <= 0)
+		{
+			return true;
+		}
+		auto const view = std::string_view(line, static_cast<std::size_t>(size));
+		auto const position = view.rfind(')');
+		return position == std::string_view::npos or position + 2 >= view.size() or (view[position + 2] != 'Z' and view[position + 2] != 'X');
+	}
+	
+	static inline auto get_monotonic_time()
+	{
+		return static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+	
+	static constexpr std::uint32_t contended_bit = 0x80000000u;
+	static constexpr auto owner_check_interval = std::chrono::milliseconds(100);
+	
+	static inline auto try_acquire_word(std::atomic<std::uint32_t> & word)
+	{
+		auto expected = std::uint32_t(0);
+		return word.compare_exchange_strong(expected, static_cast<std::uint32_t>(::getpid()));
+	}
+	
+	static inline auto acquire_word(std::atomic<std::uint32_t> & word)
+	{
+		auto const pid = static_cast<std::uint32_t>(::getpid());
+		auto contended = std::uint32_t(0);
 		while(true)
+		{
+			auto current = word.load();
+			if(current == 0)
+			{
+				if(word.compare_exchange_strong(current, pid | contended))
+				{
+					return;
+				}
+				continue;
+			}
+			if(!is_alive(static_cast<::pid_t>(current & ~contended_bit)))
+			{
+				if(word.compare_exchange_strong(current, pid | contended_bit))
+				{
+					return;
+				}
+				continue;
+			}
+			if((current & contended_bit) == 0 and !word.compare_exchange_strong(current, current | contended_bit))
+			{
+				continue;
+			}
+			contended = contended_bit;
+			futex_wait(word, current | contended_bit, owner_check_interval);
+		}
+	}
+	
+	static inline auto release_word(std::atomic<std::uint32_t> & word)
+	{
+		if(word.exchange(0) & contended_bit)
+		{
+			futex_wake(word, 1);
+		}
+	}
+	
+	static inline auto adopt_word(std::atomic<std::uint32_t> & word, std::uint32_t const owner)
+	{
+		auto const pid = static_cast<std::uint32_t>(::getpid());
+		auto current = word.load();
+		return (current & ~contended_bit) == owner and word.compare_exchange_strong(current, pid | (current & contended_bit));
+	}
+	
+	static inline auto try_take_word(std::atomic<std::uint32_t> & word, std::uint32_t const contended)
+	{
+		auto const pid = static_cast<std::uint32_t>(::getpid());
+		auto current = word.load();
+		if(current == 0)
+		{
+			return word.compare_exchange_strong(current, pid | contended);
+		}
+		if(!is_alive(static_cast<::pid_t>(current & ~contended_bit)))
+		{
+			return word.compare_exchange_strong(current, pid | contended_bit);
+		}
+		return false;
+	}
+	
+	static inline auto & get_mapping(std::string const & filename, std::size_t const size)
+	{
+		auto & singleton = get_singleton();
+		auto const guard = std::scoped_lock<std::mutex>(singleton.mapping_mtx);
+		auto & mapping = singleton.mappings[filename];
+		if(!mapping)
+		{
+			mapping = std::make_unique<mapping_t>(filename, size);
+		}
+		return *mapping;
+	}
+	
+	static inline auto get_hash(std::string_view const text)
+	{
+		auto hash = std::uint64_t(0xcbf29ce484222325ull);
+		for(auto const character : text)
+		{
+			hash = (hash ^ static_cast<unsigned char>(character)) * 0x100000001b3ull;
+		}
+		return hash ^ (hash >> 32);
+	}
+	
+	static inline auto get_path_hash(std::string const & filename)
+	{
+		return std::to_string(get_hash(get_normal_path(filename)));
+	}
+	
+	static inline auto get_stats_name(std::string const & filename)
+	{
+		return "/dev/shm/locker.stats." + get_path_hash(filename);
+	}
+	
+	static inline auto get_stats(std::string const & filename) -> std::pair<stats_t *, stats_slot_t *>
+	{
+		if(!get_singleton().is_estimating.load(std::memory_order_relaxed))
+		{
+			return {nullptr, nullptr};
+		}
+		auto & stats = *get_mapping(get_stats_name(filename), sizeof(stats_t)).get<stats_t>();
+		auto const self = static_cast<std::uint32_t>(::getpid());
+		for(auto & slot : stats.slots)
+		{
+			if(slot.pid.load() == self)
+			{
+				return {&stats, &slot};
+			}
+		}
+		for(auto & slot : stats.slots)
+		{
+			auto owner = slot.pid.load();
+			if((owner == 0 or !is_alive(static_cast<::pid_t>(owner))) and slot.pid.compare_exchange_strong(owner, self))
+			{
+				slot.waiters.store(0);
+				slot.holders.store(0);
+				slot.acquired_at.store(0);
+				return {&stats, &slot};
+			}
+		}
+		return {nullptr, nullptr};
+	}
+	
+	static inline auto record_acquire(value_t & lockfile, stats_t & stats, stats_slot_t & slot)
+	{
+		if(lockfile.stats == nullptr)
+		{
+			lockfile.stats = &stats;
+			lockfile.stats_slot = &slot;
+			if(slot.holders.fetch_add(1) == 0)
+			{
+				slot.acquired_at.store(get_monotonic_time());
+			}
+		}
+	}
+	
+	static inline auto record_hold(stats_t & stats, stats_slot_t & slot)
+	{
+		auto const acquired_at = slot.acquired_at.load();
+		if(slot.holders.fetch_sub(1) == 1)
+		{
+			slot.acquired_at.store(0);
+		}
+		if(acquired_at == 0)
+		{
+			return;
+		}
+		auto const elapsed = get_monotonic_time() - acquired_at;
+		auto hold_time = stats.hold_time.load();
+		while(!stats.hold_time.compare_exchange_weak(hold_time, hold_time == 0 ? elapsed : hold_time + (elapsed - hold_time) / 8));
+	}
+	
+	static inline auto get_identity(std::string const & filename)
+	{
+		struct ::stat status;
+		if(::stat(filename.c_str(), &status) < 0)
 		{
 			::mode_t mask = ::umask(0);
 			int descriptor = ::open(filename.c_str(), O_RDWR | O_CREAT, 0666);
 			::umask(mask);
+			if(descriptor < 0 or ::fstat(descriptor, &status) < 0)
+			{
+				if(descriptor >= 0)
+				{
+					::close(descriptor);
+				}
+				throw std::runtime_error("could not get status of file \"" + filename + "\"");
+			}
+			::close(descriptor);
+		}
+		return "/dev/shm/locker." + std::to_string(status.st_dev) + "." + std::to_string(status.st_ino);
+	}
+	
+	static inline auto prefetch(prefetch_t const & hint)
+	{
+		if(!hint.filename.empty())
+		{
+			if(auto const descriptor = ::open(hint.filename.c_str(), O_RDONLY | O_CLOEXEC); descriptor >= 0)
+			{
+				::posix_fadvise(descriptor, hint.offset, hint.length, POSIX_FADV_WILLNEED);
+				::close(descriptor);
+			}
+		}
+		if(hint.address != nullptr and hint.size > 0)
+		{
+			auto const page = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+			auto const begin = reinterpret_cast<std::uintptr_t>(hint.address) / page * page;
+			auto const end = reinterpret_cast<std::uintptr_t>(hint.address) + hint.size;
+			::madvise(reinterpret_cast<void *>(begin), end - begin, MADV_WILLNEED);
+		}
+	}
+	
+	template <bool should_not_block, bool should_share = false>
+	static inline auto try_acquire(std::string const & filename, int const flags = O_RDWR | O_CREAT, prefetch_t const * hint = nullptr) -> std::optional<std::pair<key_t, value_t>>
+	{
+		auto & singleton = get_singleton();
+		auto flag = should_share ? LOCK_SH : LOCK_EX;
+		if constexpr(should_not_block)
+		{
+			flag |= LOCK_NB;
+		}
+		while(true)
+		{
+			::mode_t mask = ::umask(0);
+			int descriptor = ::open(filename.c_str(), flags, 0666);
+			::umask(mask);
 			if(descriptor < 0)
 			{
 				throw std::runtime_error("could not open file \"" + filename + "\" for lock");
@@ -154,6 +622,10 @@ class locker
 					{
 						::close(descriptor);
 						auto & lockfile = singleton.lockfiles.at(id);
+						if(lockfile.is_shared and !should_share)
+						{
+							throw std::runtime_error("could not lock file \"" + filename + "\" because this process holds it shared");
+						}
 						++lockfile.num_locks;
 						return std::make_pair(id, lockfile);
 					}
@@ -162,20 +634,31 @@ class locker
 						singleton.lockfiles.erase(id);
 					}
 				}
-				auto flag = LOCK_EX;
-				if constexpr(should_not_block)
+				auto is_locked = false;
+				if(hint != nullptr and !should_not_block)
 				{
-					flag |= LOCK_NB;
+					is_locked = ::flock(descriptor, flag | LOCK_NB) == 0;
+					if(!is_locked and errno == EWOULDBLOCK)
+					{
+						prefetch(*hint);
+					}
 				}
-				if(::flock(descriptor, flag) < 0)
+				if(!is_locked and ::flock(descriptor, flag) < 0)
 				{
+					if(should_not_block and errno == EWOULDBLOCK)
+					{
+						::close(descriptor);
+						return std::nullopt;
+					}
 					throw std::runtime_error("could not lock file \"" + filename + "\"");
 				}
+				LOCKER_FAULT_POINT("lock");
 				struct ::stat new_status;
 				if(::stat(filename.c_str(), &new_status) >= 0 and new_status.st_nlink > 0 and new_status.st_ino == status.st_ino and new_status.st_dev == status.st_dev)
 				{
 					id = key_t(status.st_ino, status.st_dev);
-					auto const lockfile = value_t(descriptor, 1, pid);
+					auto lockfile = value_t(descriptor, 1, pid, should_share);
+					lockfile.generation = singleton.generation;
 					singleton.lockfiles.emplace(id, lockfile);
 					return std::make_pair(id, lockfile);
 				}
@@ -189,7 +672,56 @@ class locker
 		}
 	}
 	
-	template <bool should_keep_trace>
+	template <bool should_not_block, bool should_share = false>
+	static inline auto acquire(std::string const & filename, int const flags = O_RDWR | O_CREAT, prefetch_t const * hint = nullptr)
+	{
+		if(auto lockfile = try_acquire<should_not_block, should_share>(filename, flags, hint))
+		{
+			return *lockfile;
+		}
+		throw std::runtime_error("could not lock file \"" + filename + "\"");
+	}
+	
+	template <bool should_share = false>
+	static inline auto try_lock(std::string const & filename, int const flags = O_RDWR | O_CREAT)
+	{
+		auto & singleton = get_singleton();
+		auto const [stats, slot] = get_stats(filename);
+		auto const guard = std::scoped_lock<std::mutex>(singleton.mtx);
+		auto result = try_acquire<true, should_share>(filename, flags);
+		if(result and stats != nullptr)
+		{
+			record_acquire(singleton.lockfiles.at(result->first), *stats, *slot);
+		}
+		return result;
+	}
+	
+	template <bool should_not_block, bool should_share = false>
+	static inline auto lock(std::string const & filename, int const flags = O_RDWR | O_CREAT, prefetch_t const * hint = nullptr)
+	{
+		auto & singleton = get_singleton();
+		auto const [stats, slot] = get_stats(filename);
+		auto const guard = std::scoped_lock<std::mutex>(singleton.mtx);
+		if(stats == nullptr)
+		{
+			return acquire<should_not_block, should_share>(filename, flags, hint);
+		}
+		slot->waiters.fetch_add(1);
+		try
+		{
+			auto const result = acquire<should_not_block, should_share>(filename, flags, hint);
+			slot->waiters.fetch_sub(1);
+			record_acquire(singleton.lockfiles.at(result.first), *stats, *slot);
+			return result;
+		}
+		catch(...)
+		{
+			slot->waiters.fetch_sub(1);
+			throw;
+		}
+	}
+	
+	template <bool should_keep_trace, bool should_sync = true>
 	static inline auto release(int const descriptor)
 	{
 		struct ::stat descriptor_stat;
@@ -205,7 +737,7 @@ class locker
 			throw std::runtime_error("could not readlink descriptor \"" + std::to_string(descriptor) + "\"");
 		}
 		filename = filename.c_str();
-		if(descriptor_stat.st_nlink > 0)
+		if(descriptor_stat.st_nlink > 0 and !S_ISDIR(descriptor_stat.st_mode))
 		{
 			if constexpr(!should_keep_trace)
 			{
@@ -219,10 +751,11 @@ class locker
 					throw std::runtime_error("could not match file descriptor \"" + std::to_string(descriptor) + "\" with filename \"" + filename + "\"");
 				}
 			}	
-			if(::fsync(descriptor) < 0)
+			if(should_sync and ::fsync(descriptor) < 0)
 			{
 				throw std::runtime_error("could not fsync file \"" + filename + "\"");
 			}
+			LOCKER_FAULT_POINT("release");
 			if constexpr(!should_keep_trace)
 			{	
 				size = ::lseek(descriptor, 0, SEEK_END);
@@ -244,16 +777,20 @@ class locker
 	}
 	
 	template <bool should_keep_trace>
-	static inline auto unlock(key_t const & id)
+	static inline auto unlock(key_t const & id, std::uint64_t const generation)
 	{
 		auto & singleton = get_singleton();
 		auto const guard = std::scoped_lock<std::mutex>(singleton.mtx);
-		if(singleton.lockfiles.contains(id))
+		if(singleton.lockfiles.contains(id) and singleton.lockfiles.at(id).generation == generation)
 		{
 			auto & lockfile = singleton.lockfiles.at(id);
 			if(--lockfile.num_locks <= 0)
 			{
-				auto const filename = release<should_keep_trace>(lockfile.descriptor);
+				if(lockfile.stats != nullptr)
+				{
+					record_hold(*lockfile.stats, *lockfile.stats_slot);
+				}
+				auto const filename = lockfile.is_shared ? release<true, false>(lockfile.descriptor) : release<should_keep_trace>(lockfile.descriptor);
 				if(!singleton.lockfiles.erase(id))
 				{
 					throw std::runtime_error("could not remove file \"" + filename + "\" from locker");
@@ -262,52 +799,2867 @@ class locker
 		}
 	}
 	
-	~locker()
-	{
-		auto const guard = std::scoped_lock<std::mutex>(mtx);
-		for(auto const & [key, value] : lockfiles)
-		{
-			try
-			{
-				release<true>(value.descriptor);
-			}
-			catch(...)
-			{
-			}
-		}
-		lockfiles.clear();
-	}
+	static constexpr unsigned uring_entries = 256;
+	static constexpr unsigned async_entries = 4096;
+	static constexpr std::uint8_t uring_futex_wait = 51;
+	static constexpr std::uint32_t uring_cancel_all = 1u << 0;
+	static constexpr std::uint32_t uring_cancel_any = 1u << 2;
+	static constexpr std::uint32_t futex_size_32 = 2;
+	static constexpr std::size_t futex_waitv_max = 128;
+	static constexpr long futex_waitv_syscall = 449;
 	
-	locker() = default;
+	struct futex_vector_t
+	{
+		std::uint64_t value;
+		std::uint64_t address;
+		std::uint32_t flags;
+		std::uint32_t reserved;
+	};
 	
-	public:
+	static_assert(sizeof(::io_uring_sqe) == 64);
 	
-	locker(locker const &) = delete;
-	locker(locker &&) = delete;
-	locker & operator=(locker const &) = delete;
-	locker & operator=(locker &&) = delete;
+	static inline auto set_addr3(::io_uring_sqe & entry, std::uint64_t const value)
+	{
+		std::memcpy(static_cast<char *>(static_cast<void *>(&entry)) + 48, &value, sizeof(value));
+	}
 	
-	template <bool should_not_block = false, bool should_keep_trace = false>
-	class [[nodiscard]] lock_guard_t
+	class uring_t
 	{
-		key_t id;
+		int descriptor = -1;
+		void * rings[3] = {MAP_FAILED, MAP_FAILED, MAP_FAILED};
+		std::size_t sizes[3] = {0, 0, 0};
+		unsigned * sq_tail = nullptr;
+		unsigned * sq_array = nullptr;
+		unsigned sq_mask = 0;
+		unsigned * cq_head = nullptr;
+		unsigned * cq_tail = nullptr;
+		unsigned cq_mask = 0;
+		::io_uring_sqe * sqes = nullptr;
+		::io_uring_cqe * cqes = nullptr;
+		unsigned entries = 0;
 		
-		public:
+		template <typename type_t>
+		auto get(std::size_t const ring, std::size_t const offset) const
+		{
+			return static_cast<type_t *>(static_cast<void *>(static_cast<char *>(rings[ring]) + offset));
+		}
 		
-		lock_guard_t(lock_guard_t const &) = delete;
-		lock_guard_t(lock_guard_t &&) = delete;
+		auto enter(unsigned const to_submit, unsigned const min_complete) const
+		{
+			long result = 0;
+			do
+			{
+				result = ::syscall(SYS_io_uring_enter, descriptor, to_submit, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0);
+			}
+			while(result < 0 and errno == EINTR);
+			return result;
+		}
+		
+		public:
+		
+		uring_t(uring_t const &) = delete;
+		uring_t(uring_t &&) = delete;
+		uring_t & operator=(uring_t const &) = delete;
+		uring_t & operator=(uring_t &&) = delete;
+		
+		uring_t(unsigned const num_entries)
+		{
+			auto parameters = ::io_uring_params();
+			descriptor = static_cast<int>(::syscall(SYS_io_uring_setup, num_entries, &parameters));
+			if(descriptor < 0)
+			{
+				return;
+			}
+			sizes[0] = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+			sizes[1] = parameters.cq_off.cqes + parameters.cq_entries * sizeof(::io_uring_cqe);
+			sizes[2] = parameters.sq_entries * sizeof(::io_uring_sqe);
+			::off_t const offsets[3] = {IORING_OFF_SQ_RING, IORING_OFF_CQ_RING, static_cast<::off_t>(IORING_OFF_SQES)};
+			for(std::size_t i = 0; i < 3; ++i)
+			{
+				rings[i] = ::mmap(nullptr, sizes[i], PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, offsets[i]);
+				if(rings[i] == MAP_FAILED)
+				{
+					this->~uring_t();
+					descriptor = -1;
+					return;
+				}
+			}
+			sq_tail = get<unsigned>(0, parameters.sq_off.tail);
+			sq_array = get<unsigned>(0, parameters.sq_off.array);
+			sq_mask = *get<unsigned>(0, parameters.sq_off.ring_mask);
+			cq_head = get<unsigned>(1, parameters.cq_off.head);
+			cq_tail = get<unsigned>(1, parameters.cq_off.tail);
+			cq_mask = *get<unsigned>(1, parameters.cq_off.ring_mask);
+			cqes = get<::io_uring_cqe>(1, parameters.cq_off.cqes);
+			sqes = get<::io_uring_sqe>(2, 0);
+			entries = parameters.sq_entries;
+		}
+		
+		~uring_t()
+		{
+			for(std::size_t i = 0; i < 3; ++i)
+			{
+				if(rings[i] != MAP_FAILED)
+				{
+					::munmap(rings[i], sizes[i]);
+					rings[i] = MAP_FAILED;
+				}
+			}
+			if(descriptor >= 0)
+			{
+				::close(descriptor);
+			}
+		}
+		
+		auto is_available() const
+		{
+			return descriptor >= 0;
+		}
+		
+		template <typename prepare_t>
+		auto run(std::size_t const count, prepare_t && prepare, std::vector<int> & results)
+		{
+			for(std::size_t first = 0; first < count; first += entries)
+			{
+				auto const chunk = static_cast<unsigned>(std::min<std::size_t>(entries, count - first));
+				auto tail = std::atomic_ref<unsigned>(*sq_tail).load(std::memory_order_relaxed);
+				for(unsigned i = 0; i < chunk; ++i, ++tail)
+				{
+					auto const index = tail & sq_mask;
+					auto & entry = sqes[index];
+					std::memset(static_cast<void *>(&entry), 0, sizeof(entry));
+					prepare(first + i, entry);
+					entry.user_data = first + i;
+					sq_array[index] = index;
+				}
+				std::atomic_ref<unsigned>(*sq_tail).store(tail, std::memory_order_release);
+				auto const submitted = enter(chunk, chunk);
+				if(submitted < 0 and first == 0)
+				{
+					std::atomic_ref<unsigned>(*sq_tail).store(tail - chunk, std::memory_order_release);
+					return false;
+				}
+				if(submitted != chunk)
+				{
+					throw std::runtime_error("could not submit " + std::to_string(chunk) + " operations to io_uring");
+				}
+				for(unsigned completed = 0; completed < chunk;)
+				{
+					auto head = std::atomic_ref<unsigned>(*cq_head).load(std::memory_order_relaxed);
+					auto const cq_end = std::atomic_ref<unsigned>(*cq_tail).load(std::memory_order_acquire);
+					for(; head != cq_end; ++head, ++completed)
+					{
+						auto const & completion = cqes[head & cq_mask];
+						results[static_cast<std::size_t>(completion.user_data)] = completion.res;
+					}
+					std::atomic_ref<unsigned>(*cq_head).store(head, std::memory_order_release);
+					if(completed < chunk and enter(0, chunk - completed) < 0)
+					{
+						throw std::runtime_error("could not wait for io_uring completions");
+					}
+				}
+			}
+			return true;
+		}
+		
+		template <typename prepare_t>
+		auto wait_any(std::size_t const count, prepare_t && prepare, std::chrono::nanoseconds const timeout)
+		{
+			auto const chunk = static_cast<unsigned>(std::min<std::size_t>(entries - 2, count));
+			auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+			auto const spec = ::__kernel_timespec{seconds.count(), (timeout - seconds).count()};
+			auto tail = std::atomic_ref<unsigned>(*sq_tail).load(std::memory_order_relaxed);
+			auto push = [&](std::uint64_t const data) -> ::io_uring_sqe &
+			{
+				auto const index = tail++ & sq_mask;
+				auto & entry = sqes[index];
+				std::memset(static_cast<void *>(&entry), 0, sizeof(entry));
+				entry.user_data = data;
+				sq_array[index] = index;
+				return entry;
+			};
+			for(unsigned i = 0; i < chunk; ++i)
+			{
+				prepare(i, push(i));
+			}
+			auto & timer = push(chunk);
+			timer.opcode = IORING_OP_TIMEOUT;
+			timer.addr = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(&spec));
+			timer.len = 1;
+			std::atomic_ref<unsigned>(*sq_tail).store(tail, std::memory_order_release);
+			if(enter(chunk + 1, 1) != chunk + 1)
+			{
+				throw std::runtime_error("could not submit " + std::to_string(chunk) + " futex waits to io_uring");
+			}
+			auto & cancel = push(chunk + 1);
+			cancel.opcode = IORING_OP_ASYNC_CANCEL;
+			cancel.cancel_flags = uring_cancel_all | uring_cancel_any;
+			std::atomic_ref<unsigned>(*sq_tail).store(tail, std::memory_order_release);
+			if(enter(1, 0) != 1)
+			{
+				throw std::runtime_error("could not cancel futex waits in io_uring");
+			}
+			auto is_supported = true;
+			for(unsigned completed = 0; completed < chunk + 2;)
+			{
+				auto head = std::atomic_ref<unsigned>(*cq_head).load(std::memory_order_relaxed);
+				auto const cq_end = std::atomic_ref<unsigned>(*cq_tail).load(std::memory_order_acquire);
+				for(; head != cq_end; ++head, ++completed)
+				{
+					auto const & completion = cqes[head & cq_mask];
+					if(completion.user_data < chunk and completion.res == -EINVAL)
+					{
+						is_supported = false;
+					}
+				}
+				std::atomic_ref<unsigned>(*cq_head).store(head, std::memory_order_release);
+				if(completed < chunk + 2 and enter(0, chunk + 2 - completed) < 0)
+				{
+					throw std::runtime_error("could not wait for io_uring completions");
+				}
+			}
+			return is_supported;
+		}
+	};
+	
+	template <typename prepare_t, typename fallback_t>
+	static inline auto execute(std::size_t const count, prepare_t && prepare, fallback_t && fallback)
+	{
+		thread_local auto ring = uring_t(uring_entries);
+		auto results = std::vector<int>(count, 0);
+		auto const is_ringed = count > 0 and ring.is_available() and ring.run(count, prepare, results);
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			if(!is_ringed or results[i] == -EINVAL or results[i] == -EOPNOTSUPP)
+			{
+				auto const result = fallback(i);
+				results[i] = result < 0 ? -errno : result;
+			}
+		}
+		return results;
+	}
+	
+	static inline auto wait_words(std::vector<std::pair<std::atomic<std::uint32_t> *, std::uint32_t>> const & words, std::chrono::nanoseconds const timeout)
+	{
+		thread_local auto ring = uring_t(async_entries);
+		thread_local auto is_uring_supported = true;
+		thread_local auto is_waitv_supported = true;
+		if(words.empty())
+		{
+			return;
+		}
+		if(ring.is_available() and is_uring_supported)
+		{
+			is_uring_supported = ring.wait_any(words.size(), [&](std::size_t const i, ::io_uring_sqe & entry)
+			{
+				entry.opcode = uring_futex_wait;
+				entry.fd = futex_size_32;
+				entry.addr = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(words[i].first));
+				entry.addr2 = words[i].second;
+				set_addr3(entry, FUTEX_BITSET_MATCH_ANY);
+			}, timeout);
+			if(is_uring_supported)
+			{
+				return;
+			}
+		}
+		if(is_waitv_supported)
+		{
+			auto waiters = std::vector<futex_vector_t>(std::min<std::size_t>(words.size(), futex_waitv_max));
+			for(std::size_t i = 0; i < waiters.size(); ++i)
+			{
+				waiters[i] = futex_vector_t{words[i].second, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(words[i].first)), futex_size_32, 0};
+			}
+			auto const deadline = std::chrono::nanoseconds(get_monotonic_time()) + timeout;
+			auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(deadline);
+			auto const spec = ::timespec{static_cast<::time_t>(seconds.count()), static_cast<long>((deadline - seconds).count())};
+			if(::syscall(futex_waitv_syscall, waiters.data(), static_cast<unsigned>(waiters.size()), 0, &spec, CLOCK_MONOTONIC) >= 0 or errno != ENOSYS)
+			{
+				return;
+			}
+			is_waitv_supported = false;
+		}
+		futex_wait(*words.front().first, words.front().second, words.size() == 1 ? timeout : std::min<std::chrono::nanoseconds>(timeout, std::chrono::milliseconds(1)));
+	}
+	
+	static inline auto as_address(void const * pointer)
+	{
+		return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(pointer));
+	}
+	
+	static inline auto get_key(struct ::statx const & status)
+	{
+		return key_t(static_cast<::ino_t>(status.stx_ino), ::makedev(status.stx_dev_major, status.stx_dev_minor));
+	}
+	
+	static inline auto acquire_batch(std::vector<std::string> const & filenames)
+	{
+		auto & singleton = get_singleton();
+		auto const count = filenames.size();
+		auto ids = std::vector<key_t>(count);
+		::mode_t mask = ::umask(0);
+		auto descriptors = execute(count, [&](std::size_t const i, ::io_uring_sqe & entry)
+		{
+			entry.opcode = IORING_OP_OPENAT;
+			entry.fd = AT_FDCWD;
+			entry.addr = as_address(filenames[i].c_str());
+			entry.len = 0666;
+			entry.open_flags = O_RDWR | O_CREAT;
+		},
+		[&](std::size_t const i)
+		{
+			return ::open(filenames[i].c_str(), O_RDWR | O_CREAT, 0666);
+		});
+		::umask(mask);
+		auto const close_all = [&](std::size_t const first)
+		{
+			for(std::size_t i = first; i < count; ++i)
+			{
+				if(descriptors[i] >= 0)
+				{
+					::close(descriptors[i]);
+				}
+			}
+		};
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			if(descriptors[i] < 0)
+			{
+				close_all(0);
+				throw std::runtime_error("could not open file \"" + filenames[i] + "\" for lock");
+			}
+		}
+		auto statuses = std::vector<struct ::statx>(count);
+		auto results = execute(count, [&](std::size_t const i, ::io_uring_sqe & entry)
+		{
+			entry.opcode = IORING_OP_STATX;
+			entry.fd = descriptors[i];
+			entry.addr = as_address("");
+			entry.len = STATX_INO;
+			entry.off = as_address(&statuses[i]);
+			entry.statx_flags = AT_EMPTY_PATH;
+		},
+		[&](std::size_t const i)
+		{
+			return ::statx(descriptors[i], "", AT_EMPTY_PATH, STATX_INO, &statuses[i]);
+		});
+		auto const pid = ::getpid();
+		auto duplicates = std::vector<int>();
+		auto const roll_back = [&](std::size_t const end)
+		{
+			for(auto const descriptor : duplicates)
+			{
+				::close(descriptor);
+			}
+			for(std::size_t j = 0; j < end; ++j)
+			{
+				auto & lockfile = singleton.lockfiles.at(ids[j]);
+				if(--lockfile.num_locks <= 0)
+				{
+					::close(lockfile.descriptor);
+					singleton.lockfiles.erase(ids[j]);
+				}
+			}
+		};
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			try
+			{
+				if(results[i] < 0)
+				{
+					throw std::runtime_error("could not get status of file \"" + filenames[i] + "\"");
+				}
+				ids[i] = get_key(statuses[i]);
+				if(singleton.lockfiles.contains(ids[i]) and singleton.lockfiles.at(ids[i]).pid == pid)
+				{
+					if(singleton.lockfiles.at(ids[i]).is_shared)
+					{
+						throw std::runtime_error("could not lock file \"" + filenames[i] + "\" because this process holds it shared");
+					}
+					++singleton.lockfiles.at(ids[i]).num_locks;
+					duplicates.push_back(descriptors[i]);
+					descriptors[i] = -1;
+					continue;
+				}
+				singleton.lockfiles.erase(ids[i]);
+				if(::flock(descriptors[i], LOCK_EX) < 0)
+				{
+					throw std::runtime_error("could not lock file \"" + filenames[i] + "\"");
+				}
+				LOCKER_FAULT_POINT("lock");
+				struct ::statx current;
+				if(::statx(AT_FDCWD, filenames[i].c_str(), 0, STATX_INO | STATX_NLINK, &current) < 0 or current.stx_nlink == 0 or !(get_key(current) == ids[i]))
+				{
+					::close(descriptors[i]);
+					descriptors[i] = -1;
+					ids[i] = acquire<false>(filenames[i]).first;
+					continue;
+				}
+				auto & lockfile = singleton.lockfiles.emplace(ids[i], value_t(descriptors[i], 1, pid)).first->second;
+				lockfile.generation = singleton.generation;
+			}
+			catch(...)
+			{
+				close_all(i);
+				roll_back(i);
+				throw;
+			}
+		}
+		execute(duplicates.size(), [&](std::size_t const i, ::io_uring_sqe & entry)
+		{
+			entry.opcode = IORING_OP_CLOSE;
+			entry.fd = duplicates[i];
+		},
+		[&](std::size_t const i)
+		{
+			return ::close(duplicates[i]);
+		});
+		return std::make_pair(ids, singleton.generation);
+	}
+	
+	static inline auto lock_batch(std::vector<std::string> const & filenames)
+	{
+		auto & singleton = get_singleton();
+		auto stats = std::vector<std::pair<stats_t *, stats_slot_t *>>(filenames.size());
+		for(std::size_t i = 0; i < filenames.size(); ++i)
+		{
+			stats[i] = get_stats(filenames[i]);
+		}
+		auto const guard = std::scoped_lock<std::mutex>(singleton.mtx);
+		auto const wait = [&](bool const is_waiting)
+		{
+			for(auto const & [entry, slot] : stats)
+			{
+				if(slot != nullptr)
+				{
+					is_waiting ? slot->waiters.fetch_add(1) : slot->waiters.fetch_sub(1);
+				}
+			}
+		};
+		wait(true);
+		try
+		{
+			auto const result = acquire_batch(filenames);
+			wait(false);
+			for(std::size_t i = 0; i < filenames.size(); ++i)
+			{
+				if(stats[i].first != nullptr)
+				{
+					record_acquire(singleton.lockfiles.at(result.first[i]), *stats[i].first, *stats[i].second);
+				}
+			}
+			return result;
+		}
+		catch(...)
+		{
+			wait(false);
+			throw;
+		}
+	}
+	
+	template <bool should_keep_trace>
+	static inline auto unlock_batch(std::vector<std::string> const & filenames, std::vector<key_t> const & ids, std::uint64_t const generation)
+	{
+		auto & singleton = get_singleton();
+		auto const guard = std::scoped_lock<std::mutex>(singleton.mtx);
+		if(generation != singleton.generation)
+		{
+			return;
+		}
+		auto names = std::vector<std::string const *>();
+		auto descriptors = std::vector<int>();
+		for(std::size_t i = 0; i < ids.size(); ++i)
+		{
+			if(singleton.lockfiles.contains(ids[i]))
+			{
+				auto & lockfile = singleton.lockfiles.at(ids[i]);
+				if(--lockfile.num_locks <= 0)
+				{
+					if(lockfile.stats != nullptr)
+					{
+						record_hold(*lockfile.stats, *lockfile.stats_slot);
+					}
+					names.push_back(&filenames[i]);
+					descriptors.push_back(lockfile.descriptor);
+					singleton.lockfiles.erase(ids[i]);
+				}
+			}
+		}
+		auto const count = descriptors.size();
+		auto results = execute(count, [&](std::size_t const i, ::io_uring_sqe & entry)
+		{
+			entry.opcode = IORING_OP_FSYNC;
+			entry.fd = descriptors[i];
+		},
+		[&](std::size_t const i)
+		{
+			return ::fsync(descriptors[i]);
+		});
+		auto is_failed = std::find_if(results.begin(), results.end(), [](int const result) { return result < 0; }) != results.end();
+		if constexpr(!should_keep_trace)
+		{
+			auto statuses = std::vector<struct ::statx>(2 * count);
+			auto const inspections = execute(2 * count, [&](std::size_t const i, ::io_uring_sqe & entry)
+			{
+				entry.opcode = IORING_OP_STATX;
+				entry.fd = i < count ? descriptors[i] : AT_FDCWD;
+				entry.addr = as_address(i < count ? "" : names[i - count]->c_str());
+				entry.len = STATX_INO | STATX_NLINK | STATX_SIZE;
+				entry.off = as_address(&statuses[i]);
+				entry.statx_flags = i < count ? AT_EMPTY_PATH : 0;
+			},
+			[&](std::size_t const i)
+			{
+				return i < count ? ::statx(descriptors[i], "", AT_EMPTY_PATH, STATX_INO | STATX_NLINK | STATX_SIZE, &statuses[i]) : ::statx(AT_FDCWD, names[i - count]->c_str(), 0, STATX_INO, &statuses[i]);
+			});
+			auto erasables = std::vector<std::string const *>();
+			for(std::size_t i = 0; i < count; ++i)
+			{
+				if(inspections[i] >= 0 and inspections[count + i] >= 0 and statuses[i].stx_nlink > 0 and statuses[i].stx_size == 0 and get_key(statuses[i]) == get_key(statuses[count + i]))
+				{
+					LOCKER_FAULT_POINT("release");
+					erasables.push_back(names[i]);
+				}
+			}
+			results = execute(erasables.size(), [&](std::size_t const i, ::io_uring_sqe & entry)
+			{
+				entry.opcode = IORING_OP_UNLINKAT;
+				entry.fd = AT_FDCWD;
+				entry.addr = as_address(erasables[i]->c_str());
+			},
+			[&](std::size_t const i)
+			{
+				return ::unlink(erasables[i]->c_str());
+			});
+			is_failed = is_failed or std::find_if(results.begin(), results.end(), [](int const result) { return result < 0; }) != results.end();
+		}
+		results = execute(count, [&](std::size_t const i, ::io_uring_sqe & entry)
+		{
+			entry.opcode = IORING_OP_CLOSE;
+			entry.fd = descriptors[i];
+		},
+		[&](std::size_t const i)
+		{
+			return ::close(descriptors[i]);
+		});
+		if(is_failed or std::find_if(results.begin(), results.end(), [](int const result) { return result < 0; }) != results.end())
+		{
+			throw std::runtime_error("could not release every file of a batch");
+		}
+	}
+	
+	static inline auto send_file(int const source, int const target, ::off_t offset, std::size_t const count)
+	{
+		struct ::stat status;
+		if(::fstat(target, &status) < 0)
+		{
+			throw std::runtime_error("could not fstat descriptor \"" + std::to_string(target) + "\"");
+		}
+		auto const is_pipe = S_ISFIFO(status.st_mode);
+		auto is_file = S_ISREG(status.st_mode);
+		std::size_t sent = 0;
+		while(sent < count)
+		{
+			auto const chunk = std::min<std::size_t>(count - sent, 1 << 30);
+			::ssize_t size = 0;
+			if(is_pipe)
+			{
+				size = ::splice(source, &offset, target, nullptr, chunk, SPLICE_F_MOVE);
+			}
+			else if(is_file)
+			{
+				size = ::copy_file_range(source, &offset, target, nullptr, chunk, 0);
+				if(size < 0 and (errno == EXDEV or errno == EINVAL or errno == ENOSYS or errno == EOPNOTSUPP))
+				{
+					is_file = false;
+					continue;
+				}
+			}
+			else
+			{
+				size = ::sendfile(target, source, &offset, chunk);
+			}
+			if(size < 0 and errno == EINTR)
+			{
+				continue;
+			}
+			if(size < 0 and (errno == EAGAIN or errno == EWOULDBLOCK) and sent > 0)
+			{
+				break;
+			}
+			if(size < 0)
+			{
+				throw std::runtime_error("could not send descriptor \"" + std::to_string(source) + "\" to descriptor \"" + std::to_string(target) + "\"");
+			}
+			if(size == 0)
+			{
+				break;
+			}
+			sent += static_cast<std::size_t>(size);
+		}
+		return sent;
+	}
+	
+	static inline auto get_temporary_filename(std::string const & target)
+	{
+		static auto counter = std::atomic<std::uint64_t>(0);
+		return target + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(counter.fetch_add(1));
+	}
+	
+	static inline auto write_file(std::string const & target, std::string const & contents)
+	{
+		auto const temporary = get_temporary_filename(target);
+		::mode_t mask = ::umask(0);
+		int descriptor = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+		::umask(mask);
+		if(descriptor < 0)
+		{
+			throw std::runtime_error("could not open file \"" + temporary + "\" for writing");
+		}
+		auto const is_written = ::write(descriptor, contents.data(), contents.size()) == static_cast<::ssize_t>(contents.size()) and ::fsync(descriptor) == 0;
+		::close(descriptor);
+		if(!is_written or ::rename(temporary.c_str(), target.c_str()) < 0)
+		{
+			::unlink(temporary.c_str());
+			throw std::runtime_error("could not write file \"" + target + "\"");
+		}
+	}
+	
+	static inline auto read_file(std::string const & filename)
+	{
+		auto contents = std::optional<std::string>();
+		int descriptor = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+		if(descriptor < 0)
+		{
+			return contents;
+		}
+		contents.emplace();
+		char buffer[65536];
+		::ssize_t size = 0;
+		while((size = ::read(descriptor, buffer, sizeof(buffer))) > 0)
+		{
+			contents->append(buffer, static_cast<std::size_t>(size));
+		}
+		::close(descriptor);
+		if(size < 0)
+		{
+			throw std::runtime_error("could not read file \"" + filename + "\"");
+		}
+		return contents;
+	}
+	
+	static constexpr std::size_t max_waiters = 1024;
+	static constexpr auto waiter_aging = std::chrono::milliseconds(100);
+	
+	struct waiter_t
+	{
+		std::atomic<::pid_t> pid;
+		std::atomic<int> priority;
+		std::atomic<std::int64_t> since;
+		std::atomic<std::uint32_t> wake;
+	};
+	
+	struct waiters_t
+	{
+		std::atomic<::pid_t> active;
+		waiter_t slots[max_waiters];
+	};
+	
+	static inline auto get_score(waiter_t const & waiter, std::int64_t const now)
+	{
+		auto const aging = std::chrono::duration_cast<std::chrono::nanoseconds>(waiter_aging).count();
+		return static_cast<std::int64_t>(waiter.priority.load()) * aging + (now - waiter.since.load());
+	}
+	
+	static inline auto clear_if_dead(waiter_t & waiter)
+	{
+		auto pid = waiter.pid.load();
+		if(pid != 0 and !is_alive(pid < 0 ? -pid : pid))
+		{
+			waiter.pid.compare_exchange_strong(pid, 0);
+			return true;
+		}
+		return false;
+	}
+	
+	static inline auto get_head(waiters_t & waiters, bool const should_sweep)
+	{
+		auto const now = get_monotonic_time();
+		auto head = max_waiters;
+		auto best = std::int64_t(0);
+		for(std::size_t i = 0; i < max_waiters; ++i)
+		{
+			auto & waiter = waiters.slots[i];
+			if(waiter.pid.load() <= 0 or (should_sweep and clear_if_dead(waiter)))
+			{
+				continue;
+			}
+			if(auto const score = get_score(waiter, now); head == max_waiters or score > best)
+			{
+				head = i;
+				best = score;
+			}
+		}
+		return head;
+	}
+	
+	static inline auto is_held(std::string const & filename)
+	{
+		auto & singleton = get_singleton();
+		auto const guard = std::scoped_lock<std::mutex>(singleton.mtx);
+		struct ::stat status;
+		if(::stat(filename.c_str(), &status) < 0)
+		{
+			return false;
+		}
+		auto const id = key_t(status.st_ino, status.st_dev);
+		return singleton.lockfiles.contains(id) and singleton.lockfiles.at(id).pid == ::getpid();
+	}
+	
+	static inline auto lock_by_priority(std::string const & filename, int const priority)
+	{
+		if(is_held(filename))
+		{
+			return lock<false>(filename);
+		}
+		auto & waiters = *get_mapping("/dev/shm/locker.waiters." + get_path_hash(filename), sizeof(waiters_t)).get<waiters_t>();
+		auto const pid = ::getpid();
+		auto index = max_waiters;
+		for(std::size_t i = 0; i < max_waiters and index == max_waiters; ++i)
+		{
+			auto expected = 0;
+			if(waiters.slots[i].pid.compare_exchange_strong(expected, -pid))
+			{
+				index = i;
+			}
+		}
+		if(index == max_waiters)
+		{
+			throw std::runtime_error("could not enqueue waiter for file \"" + filename + "\"");
+		}
+		auto & slot = waiters.slots[index];
+		slot.priority.store(priority);
+		slot.since.store(get_monotonic_time());
+		slot.pid.store(pid);
+		auto [stats, stats_slot] = get_stats(filename);
+		if(stats_slot != nullptr)
+		{
+			stats_slot->waiters.fetch_add(1);
+		}
+		auto const stop_waiting = [&]()
+		{
+			if(stats_slot != nullptr)
+			{
+				stats_slot->waiters.fetch_sub(1);
+				stats_slot = nullptr;
+			}
+		};
+		auto const wake_head = [&]()
+		{
+			if(auto const head = get_head(waiters, true); head != max_waiters)
+			{
+				waiters.slots[head].wake.fetch_add(1);
+				futex_wake(waiters.slots[head].wake, 1);
+			}
+		};
+		auto const leave = [&]()
+		{
+			stop_waiting();
+			slot.pid.store(0);
+			auto expected = pid;
+			waiters.active.compare_exchange_strong(expected, 0);
+			wake_head();
+		};
+		try
+		{
+			while(true)
+			{
+				auto const wake = slot.wake.load();
+				auto const head = get_head(waiters, false);
+				auto active = ::pid_t(0);
+				if(head == index and waiters.active.compare_exchange_strong(active, pid))
+				{
+					stop_waiting();
+					auto result = lock<false>(filename);
+					leave();
+					return result;
+				}
+				if(!futex_wait(slot.wake, wake, waiter_aging))
+				{
+					auto is_cleared = head != index and head != max_waiters and clear_if_dead(waiters.slots[head]);
+					if(active = waiters.active.load(); active != 0 and !is_alive(active))
+					{
+						is_cleared = waiters.active.compare_exchange_strong(active, 0) or is_cleared;
+					}
+					if(is_cleared)
+					{
+						wake_head();
+					}
+				}
+			}
+		}
+		catch(...)
+		{
+			leave();
+			throw;
+		}
+	}
+	
+	static constexpr std::size_t num_counters = 6;
+	
+	struct sample_t
+	{
+		std::int64_t time = 0;
+		std::uint64_t values[num_counters] = {};
+	};
+	
+	class counters_t
+	{
+		int descriptors[num_counters] = {-1, -1, -1, -1, -1, -1};
+		
+		static auto open_counter(std::uint32_t const type, std::uint64_t const config)
+		{
+			auto attributes = ::perf_event_attr();
+			attributes.size = sizeof(attributes);
+			attributes.type = type;
+			attributes.config = config;
+			attributes.exclude_hv = 1;
+			auto descriptor = static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+			if(descriptor < 0)
+			{
+				attributes.exclude_kernel = 1;
+				descriptor = static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+			}
+			return descriptor;
+		}
+		
+		public:
+		
+		counters_t(counters_t const &) = delete;
+		counters_t(counters_t &&) = delete;
+		counters_t & operator=(counters_t const &) = delete;
+		counters_t & operator=(counters_t &&) = delete;
+		
+		counters_t()
+		{
+			descriptors[0] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+			descriptors[1] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+			descriptors[2] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+			descriptors[3] = open_counter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+			descriptors[4] = open_counter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+			descriptors[5] = open_counter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+		}
+		
+		~counters_t()
+		{
+			for(auto const descriptor : descriptors)
+			{
+				if(descriptor >= 0)
+				{
+					::close(descriptor);
+				}
+			}
+		}
+		
+		auto read()
+		{
+			auto sample = sample_t();
+			for(std::size_t i = 0; i < num_counters; ++i)
+			{
+				if(descriptors[i] >= 0 and ::read(descriptors[i], &sample.values[i], sizeof(std::uint64_t)) != sizeof(std::uint64_t))
+				{
+					sample.values[i] = 0;
+				}
+			}
+			sample.time = get_monotonic_time();
+			return sample;
+		}
+	};
+	
+	static inline auto get_sample()
+	{
+		thread_local auto counters = counters_t();
+		return counters.read();
+	}
+	
+	static inline auto add_profile(std::string const & filename, sample_t const & start, std::thread::id const thread)
+	{
+		auto end = start;
+		if(thread == std::this_thread::get_id())
+		{
+			end = get_sample();
+		}
+		else
+		{
+			end.time = get_monotonic_time();
+		}
+		auto & singleton = get_singleton();
+		auto const guard = std::scoped_lock<std::mutex>(singleton.mtx);
+		auto & profile = singleton.profiles[filename];
+		++profile.holds;
+		profile.nanoseconds += static_cast<std::uint64_t>(end.time - start.time);
+		profile.instructions += end.values[0] - start.values[0];
+		profile.cycles += end.values[1] - start.values[1];
+		profile.cache_misses += end.values[2] - start.values[2];
+		profile.context_switches += end.values[3] - start.values[3];
+		profile.page_faults += end.values[4] - start.values[4];
+		profile.task_clock += end.values[5] - start.values[5];
+	}
+	
+	static inline void on_lease_break(int, ::siginfo_t * info, void *)
+	{
+		::fcntl(info->si_fd, F_SETLEASE, F_UNLCK);
+	}
+	
+	static inline auto install_lease_handler()
+	{
+		struct ::sigaction action;
+		if(::sigaction(LOCKER_LEASE_SIGNAL, nullptr, &action) < 0)
+		{
+			return false;
+		}
+		if(!(action.sa_flags & SA_SIGINFO) and action.sa_handler == SIG_DFL)
+		{
+			std::memset(&action, 0, sizeof(action));
+			action.sa_sigaction = on_lease_break;
+			action.sa_flags = SA_SIGINFO | SA_RESTART;
+			::sigemptyset(&action.sa_mask);
+			return ::sigaction(LOCKER_LEASE_SIGNAL, &action, nullptr) == 0;
+		}
+		return (action.sa_flags & SA_SIGINFO) and action.sa_sigaction == on_lease_break;
+	}
+	
+	struct queue_header_t
+	{
+		std::atomic<std::uint32_t> word;
+		std::atomic<std::uint32_t> pushed;
+		std::atomic<std::uint32_t> popped;
+		std::atomic<std::uint32_t> sleepers;
+		std::atomic<std::uint64_t> head;
+		std::atomic<std::uint64_t> tail;
+		std::atomic<std::uint64_t> element_size;
+		std::atomic<std::uint64_t> capacity;
+	};
+	
+	static constexpr std::size_t queue_header_size = (sizeof(queue_header_t) + 63) / 64 * 64;
+	
+	static constexpr std::uint64_t arena_magic = 0x616e657261726b6cull;
+	static constexpr std::size_t arena_block_header = 16;
+	static constexpr std::size_t arena_min_class = 5;
+	static constexpr std::size_t arena_max_class = 40;
+	static constexpr std::size_t arena_initial_size = 65536;
+	
+	struct arena_header_t
+	{
+		std::uint64_t magic;
+		std::uint64_t size;
+		std::uint64_t top;
+		std::uint64_t root;
+		std::uint64_t free_lists[arena_max_class + 1];
+	};
+	
+	static constexpr std::size_t arena_header_size = (sizeof(arena_header_t) + 63) / 64 * 64;
+	
+	static constexpr std::uint32_t max_cohort_passes = 64;
+	
+	static constexpr std::size_t max_cohort_waiters = 128;
+	
+	struct cohort_waiter_t
+	{
+		std::atomic<std::uint32_t> pid;
+		std::atomic<std::uint32_t> count;
+	};
+	
+	struct cohort_node_t
+	{
+		std::atomic<std::uint32_t> word;
+		std::atomic<std::uint32_t> passer;
+		std::atomic<std::uint32_t> passes;
+		cohort_waiter_t waiters[max_cohort_waiters];
+	};
+	
+	static inline auto get_cohort_waiter(cohort_node_t & node) -> cohort_waiter_t *
+	{
+		auto const self = static_cast<std::uint32_t>(::getpid());
+		for(auto & waiter : node.waiters)
+		{
+			if(waiter.pid.load() == self)
+			{
+				return &waiter;
+			}
+		}
+		for(auto & waiter : node.waiters)
+		{
+			auto owner = waiter.pid.load();
+			if((owner == 0 or (waiter.count.load() == 0 and !is_alive(static_cast<::pid_t>(owner)))) and waiter.pid.compare_exchange_strong(owner, self))
+			{
+				waiter.count.store(0);
+				return &waiter;
+			}
+		}
+		return nullptr;
+	}
+	
+	static inline auto has_cohort_waiters(cohort_node_t & node)
+	{
+		for(auto & waiter : node.waiters)
+		{
+			if(waiter.count.load() == 0)
+			{
+				continue;
+			}
+			auto owner = waiter.pid.load();
+			if(is_alive(static_cast<::pid_t>(owner)))
+			{
+				return true;
+			}
+			waiter.count.store(0);
+			waiter.pid.compare_exchange_strong(owner, 0);
+		}
+		return false;
+	}
+	
+	static inline auto get_node()
+	{
+		unsigned cpu = 0;
+		unsigned node = 0;
+		if(::getcpu(&cpu, &node) < 0)
+		{
+			node = 0;
+		}
+		return node;
+	}
+	
+	static inline auto lock_cohort(std::atomic<std::uint32_t> & global, cohort_node_t & node)
+	{
+		auto * const waiter = get_cohort_waiter(node);
+		if(waiter != nullptr)
+		{
+			waiter->count.fetch_add(1);
+		}
+		acquire_word(node.word);
+		if(waiter != nullptr)
+		{
+			waiter->count.fetch_sub(1);
+		}
+		auto const passer = node.passer.exchange(0);
+		if(passer == 0 or !adopt_word(global, passer))
+		{
+			acquire_word(global);
+			node.passes.store(0);
+		}
+	}
+	
+	static inline auto unlock_cohort(std::atomic<std::uint32_t> & global, cohort_node_t & node)
+	{
+		if(node.passes.load() < max_cohort_passes and has_cohort_waiters(node))
+		{
+			node.passes.fetch_add(1);
+			node.passer.store(static_cast<std::uint32_t>(::getpid()));
+		}
+		else
+		{
+			release_word(global);
+		}
+		release_word(node.word);
+	}
+	
+	struct rate_header_t
+	{
+		std::atomic<std::uint32_t> word;
+		std::atomic<std::int64_t> tat;
+		std::atomic<std::int64_t> interval;
+		std::atomic<std::int64_t> tolerance;
+	};
+	
+	static constexpr std::uint32_t max_keyed_depth = 12;
+	static constexpr std::uint32_t max_keyed_slots = 4096;
+	static constexpr std::uint32_t keyed_split_threshold = 64;
+	
+	struct alignas(64) keyed_slot_t
+	{
+		std::atomic<std::uint32_t> word;
+		std::atomic<std::uint32_t> local_depth;
+		std::atomic<std::uint32_t> contentions;
+		std::atomic<std::uint32_t> is_mixed;
+		std::atomic<std::uint32_t> split_to;
+		std::atomic<std::uint64_t> holder;
+	};
+	
+	struct keyed_header_t
+	{
+		std::atomic<std::uint32_t> word;
+		std::atomic<std::uint32_t> depth;
+		std::atomic<std::uint32_t> count;
+		std::atomic<std::uint32_t> directory[std::size_t(1) << max_keyed_depth];
+		keyed_slot_t slots[max_keyed_slots];
+	};
+	
+	static constexpr std::uint32_t max_epoch_readers = 1024;
+	
+	struct alignas(64) epoch_slot_t
+	{
+		std::atomic<std::uint32_t> pid;
+		std::atomic<std::uint64_t> epoch;
+	};
+	
+	struct epoch_table_t
+	{
+		alignas(64) std::atomic<std::uint64_t> epoch;
+		std::atomic<std::uint32_t> count;
+		std::atomic<std::uint32_t> waiters;
+		std::atomic<std::uint32_t> generation;
+		epoch_slot_t slots[max_epoch_readers];
+	};
+	
+	struct sync_policy_t
+	{
+		std::size_t max_records = SIZE_MAX;
+		std::chrono::nanoseconds max_delay = std::chrono::nanoseconds::max();
+	};
+	
+	struct append_header_t
+	{
+		std::atomic<std::uint32_t> generation;
+	};
+	
+	auto release_lockfiles()
+	{
+		++generation;
+		for(auto const & [key, value] : lockfiles)
+		{
+			if(value.stats != nullptr)
+			{
+				record_hold(*value.stats, *value.stats_slot);
+			}
+		}
+		auto const mode = static_cast<teardown_t>(teardown.load());
+		if(mode == teardown_t::fsync_each)
+		{
+			for(auto const & [key, value] : lockfiles)
+			{
+				try
+				{
+					release<true>(value.descriptor);
+				}
+				catch(...)
+				{
+				}
+			}
+		}
+		else
+		{
+			auto descriptors = std::vector<int>();
+			auto devices = std::map<::dev_t, int>();
+			for(auto const & [key, value] : lockfiles)
+			{
+				descriptors.push_back(value.descriptor);
+				devices.emplace(key.device, value.descriptor);
+			}
+			if(mode == teardown_t::syncfs_once)
+			{
+				for(auto const & [device, descriptor] : devices)
+				{
+					::syncfs(descriptor);
+				}
+			}
+			std::sort(descriptors.begin(), descriptors.end());
+			for(std::size_t first = 0, last = 0; first < descriptors.size(); first = ++last)
+			{
+				while(last + 1 < descriptors.size() and descriptors[last + 1] == descriptors[last] + 1)
+				{
+					++last;
+				}
+				#ifdef SYS_close_range
+				auto const is_closed = ::syscall(SYS_close_range, static_cast<unsigned>(descriptors[first]), static_cast<unsigned>(descriptors[last]), 0) == 0;
+				#else
+				auto const is_closed = false;
+				#endif
+				if(!is_closed)
+				{
+					for(auto i = first; i <= last; ++i)
+					{
+						::close(descriptors[i]);
+					}
+				}
+			}
+		}
+		lockfiles.clear();
+	}
+	
+	~locker()
+	{
+		auto const guard = std::scoped_lock<std::mutex>(mtx);
+		release_lockfiles();
+	}
+	
+	locker() = default;
+	
+	public:
+	
+	locker(locker const &) = delete;
+	locker(locker &&) = delete;
+	locker & operator=(locker const &) = delete;
+	locker & operator=(locker &&) = delete;
+	
+	enum class teardown_t
+	{
+		fsync_each,
+		syncfs_once,
+		close_only
+	};
+	
+	template <bool should_not_block = false, bool should_keep_trace = false, bool should_share = false>
+	class [[nodiscard]] lock_guard_t
+	{
+		key_t id;
+		std::uint64_t generation = 0;
+		int descriptor = -1;
+		std::string profiled;
+		sample_t start;
+		std::thread::id thread;
+		
+		auto begin_profile(std::string const & filename)
+		{
+			if(get_singleton().is_profiling.load(std::memory_order_relaxed))
+			{
+				profiled = get_normal_path(filename);
+				thread = std::this_thread::get_id();
+				start = get_sample();
+			}
+		}
+		
+		public:
+		
+		lock_guard_t(lock_guard_t const &) = delete;
+		lock_guard_t(lock_guard_t &&) = delete;
 		lock_guard_t & operator=(lock_guard_t const &) = delete;
 		lock_guard_t & operator=(lock_guard_t &&) = delete;
 		lock_guard_t * operator&() = delete;
 		
-		lock_guard_t(std::string const & filename)
+		lock_guard_t(std::string const & filename)
+		{
+			auto const [key, lockfile] = lock<should_not_block, should_share>(filename);
+			id = key;
+			generation = lockfile.generation;
+			descriptor = lockfile.descriptor;
+			begin_profile(filename);
+		}
+		
+		template <typename policy_t>
+		lock_guard_t(std::string const & filename, policy_t && policy) requires(should_not_block and std::is_invocable_v<policy_t, std::size_t, std::string const &>)
+		{
+			for(std::size_t attempt = 0; ; ++attempt)
+			{
+				if(auto const lockfile = try_lock<should_share>(filename))
+				{
+					id = lockfile->first;
+					generation = lockfile->second.generation;
+					descriptor = lockfile->second.descriptor;
+					begin_profile(filename);
+					return;
+				}
+				auto const delay = std::optional<std::chrono::nanoseconds>(policy(attempt, filename));
+				if(!delay)
+				{
+					throw std::runtime_error("could not lock file \"" + filename + "\" within its backoff policy");
+				}
+				std::this_thread::sleep_for(*delay);
+			}
+		}
+		
+		lock_guard_t(std::string const & filename, directory_t)
+		{
+			auto const [key, lockfile] = lock<should_not_block, should_share>(filename, O_RDONLY | O_DIRECTORY);
+			id = key;
+			generation = lockfile.generation;
+			descriptor = lockfile.descriptor;
+			begin_profile(filename);
+		}
+		
+		lock_guard_t(std::string const & filename, prefetch_t const & hint) requires(!should_not_block)
+		{
+			auto const [key, lockfile] = lock<should_not_block, should_share>(filename, O_RDWR | O_CREAT, &hint);
+			id = key;
+			generation = lockfile.generation;
+			descriptor = lockfile.descriptor;
+			begin_profile(filename);
+		}
+		
+		lock_guard_t(std::string const & filename, int const priority) requires(!should_not_block and !should_share)
+		{
+			auto const [key, lockfile] = lock_by_priority(filename, priority);
+			id = key;
+			generation = lockfile.generation;
+			descriptor = lockfile.descriptor;
+			begin_profile(filename);
+		}
+		
+		~lock_guard_t()
+		{
+			if(!profiled.empty())
+			{
+				add_profile(profiled, start, thread);
+			}
+			unlock<should_keep_trace>(id, generation);
+		}
+		
+		auto send(int const target, ::off_t const offset = 0, std::size_t const count = SIZE_MAX) const
+		{
+			auto & singleton = get_singleton();
+			auto source = -1;
+			{
+				auto const guard = std::scoped_lock<std::mutex>(singleton.mtx);
+				if(!singleton.lockfiles.contains(id) or singleton.lockfiles.at(id).generation != generation)
+				{
+					throw std::runtime_error("could not send file because its lock was released");
+				}
+				source = ::dup(descriptor);
+			}
+			if(source < 0)
+			{
+				throw std::runtime_error("could not duplicate descriptor \"" + std::to_string(descriptor) + "\"");
+			}
+			try
+			{
+				auto const sent = send_file(source, target, offset, count);
+				::close(source);
+				return sent;
+			}
+			catch(...)
+			{
+				::close(source);
+				throw;
+			}
+		}
+	};
+	
+	template <bool should_keep_trace = false>
+	class [[nodiscard]] batch_guard_t
+	{
+		std::vector<std::string> filenames;
+		std::vector<key_t> ids;
+		std::uint64_t generation = 0;
+		
+		public:
+		
+		batch_guard_t(batch_guard_t const &) = delete;
+		batch_guard_t(batch_guard_t &&) = delete;
+		batch_guard_t & operator=(batch_guard_t const &) = delete;
+		batch_guard_t & operator=(batch_guard_t &&) = delete;
+		batch_guard_t * operator&() = delete;
+		
+		batch_guard_t(std::vector<std::string> const & _filenames) : filenames(_filenames)
+		{
+			std::sort(filenames.begin(), filenames.end());
+			filenames.erase(std::unique(filenames.begin(), filenames.end()), filenames.end());
+			std::tie(ids, generation) = lock_batch(filenames);
+		}
+		
+		~batch_guard_t()
+		{
+			unlock_batch<should_keep_trace>(filenames, ids, generation);
+		}
+	};
+	
+	template <bool should_keep_trace = false>
+	class chain_t
+	{
+		std::vector<std::string> filenames;
+		
+		public:
+		
+		class [[nodiscard]] iterator_t
+		{
+			std::vector<std::string> const & filenames;
+			std::size_t index = 0;
+			key_t id;
+			std::uint64_t generation = 0;
+			
+			public:
+			
+			iterator_t(iterator_t const &) = delete;
+			iterator_t(iterator_t &&) = delete;
+			iterator_t & operator=(iterator_t const &) = delete;
+			iterator_t & operator=(iterator_t &&) = delete;
+			iterator_t * operator&() = delete;
+			
+			iterator_t(std::vector<std::string> const & _filenames) : filenames(_filenames)
+			{
+				if(!filenames.empty())
+				{
+					auto const [key, lockfile] = lock<false>(filenames.front());
+					id = key;
+					generation = lockfile.generation;
+				}
+			}
+			
+			~iterator_t()
+			{
+				if(index < filenames.size())
+				{
+					unlock<should_keep_trace>(id, generation);
+				}
+			}
+			
+			auto & operator++()
+			{
+				if(index + 1 < filenames.size())
+				{
+					auto const [key, lockfile] = lock<false>(filenames[index + 1]);
+					unlock<should_keep_trace>(id, generation);
+					id = key;
+					generation = lockfile.generation;
+				}
+				else if(index < filenames.size())
+				{
+					unlock<should_keep_trace>(id, generation);
+				}
+				++index;
+				return *this;
+			}
+			
+			auto const & operator*() const
+			{
+				return filenames[index];
+			}
+			
+			auto get_index() const
+			{
+				return index;
+			}
+			
+			auto operator==(std::default_sentinel_t) const
+			{
+				return index >= filenames.size();
+			}
+		};
+		
+		chain_t(chain_t const &) = delete;
+		chain_t(chain_t &&) = delete;
+		chain_t & operator=(chain_t const &) = delete;
+		chain_t & operator=(chain_t &&) = delete;
+		
+		chain_t(std::vector<std::string> const & _filenames) : filenames(_filenames)
+		{
+		}
+		
+		auto begin() const
+		{
+			return iterator_t(filenames);
+		}
+		
+		auto end() const
+		{
+			return std::default_sentinel;
+		}
+	};
+	
+	class read_cache_t
+	{
+		std::string filename;
+		std::string contents;
+		int descriptor = -1;
+		
+		auto drop()
+		{
+			if(descriptor >= 0)
+			{
+				::fcntl(descriptor, F_SETLEASE, F_UNLCK);
+				::close(descriptor);
+				descriptor = -1;
+			}
+		}
+		
+		auto refresh()
+		{
+			drop();
+			struct ::stat status;
+			auto const [id, lockfile] = lock<false, true>(filename, O_RDONLY);
+			try
+			{
+				descriptor = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+				if(descriptor < 0 or ::fstat(descriptor, &status) < 0)
+				{
+					drop();
+					throw std::runtime_error("could not open file \"" + filename + "\" for caching");
+				}
+				contents.resize(static_cast<std::size_t>(status.st_size));
+				std::size_t offset = 0;
+				while(offset < contents.size())
+				{
+					auto const size = ::pread(descriptor, &contents[offset], contents.size() - offset, static_cast<::off_t>(offset));
+					if(size < 0)
+					{
+						drop();
+						throw std::runtime_error("could not read file \"" + filename + "\" for caching");
+					}
+					if(size == 0)
+					{
+						break;
+					}
+					offset += static_cast<std::size_t>(size);
+				}
+				contents.resize(offset);
+				unlock<true>(id, lockfile.generation);
+			}
+			catch(...)
+			{
+				unlock<true>(id, lockfile.generation);
+				throw;
+			}
+			static auto const is_installed = install_lease_handler();
+			struct ::stat new_status;
+			if(!is_installed or ::fcntl(descriptor, F_SETSIG, LOCKER_LEASE_SIGNAL) < 0 or ::fcntl(descriptor, F_SETLEASE, F_RDLCK) < 0 or ::fstat(descriptor, &new_status) < 0
+				or new_status.st_size != status.st_size or new_status.st_mtim.tv_sec != status.st_mtim.tv_sec or new_status.st_mtim.tv_nsec != status.st_mtim.tv_nsec)
+			{
+				drop();
+			}
+		}
+		
+		public:
+		
+		read_cache_t(read_cache_t const &) = delete;
+		read_cache_t(read_cache_t &&) = delete;
+		read_cache_t & operator=(read_cache_t const &) = delete;
+		read_cache_t & operator=(read_cache_t &&) = delete;
+		
+		read_cache_t(std::string const & _filename) : filename(_filename)
+		{
+		}
+		
+		~read_cache_t()
+		{
+			drop();
+		}
+		
+		auto is_cached() const
+		{
+			return descriptor >= 0 and ::fcntl(descriptor, F_GETLEASE) == F_RDLCK;
+		}
+		
+		auto const & get()
+		{
+			if(!is_cached())
+			{
+				refresh();
+			}
+			return contents;
+		}
+	};
+	
+	class [[nodiscard]] cohort_guard_t
+	{
+		std::atomic<std::uint32_t> * global = nullptr;
+		cohort_node_t * node = nullptr;
+		
+		public:
+		
+		cohort_guard_t(cohort_guard_t const &) = delete;
+		cohort_guard_t(cohort_guard_t &&) = delete;
+		cohort_guard_t & operator=(cohort_guard_t const &) = delete;
+		cohort_guard_t & operator=(cohort_guard_t &&) = delete;
+		cohort_guard_t * operator&() = delete;
+		
+		cohort_guard_t(std::string const & filename)
+		{
+			auto const name = get_identity(filename) + ".cohort";
+			global = get_mapping(name, sizeof(std::atomic<std::uint32_t>)).get<std::atomic<std::uint32_t>>();
+			node = get_mapping(name + "." + std::to_string(LOCKER_NUMA_NODE(get_node())), sizeof(cohort_node_t)).get<cohort_node_t>();
+			lock_cohort(*global, *node);
+		}
+		
+		~cohort_guard_t()
+		{
+			unlock_cohort(*global, *node);
+		}
+	};
+	
+	template <typename type_t, std::size_t capacity>
+	class queue_t
+	{
+		static_assert(std::is_trivially_copyable_v<type_t> and alignof(type_t) <= 64 and capacity > 0);
+		
+		mapping_t mapping;
+		queue_header_t * header = nullptr;
+		type_t * slots = nullptr;
+		
+		auto sleep(std::atomic<std::uint32_t> & generation, std::uint32_t const expected)
+		{
+			header->sleepers.fetch_add(1);
+			futex_wait(generation, expected, owner_check_interval);
+			header->sleepers.fetch_sub(1);
+		}
+		
+		auto wake(std::atomic<std::uint32_t> & generation)
+		{
+			generation.fetch_add(1);
+			if(header->sleepers.load() > 0)
+			{
+				futex_wake(generation);
+			}
+		}
+		
+		public:
+		
+		queue_t(queue_t const &) = delete;
+		queue_t(queue_t &&) = delete;
+		queue_t & operator=(queue_t const &) = delete;
+		queue_t & operator=(queue_t &&) = delete;
+		
+		queue_t(std::string const & filename) : mapping(filename, queue_header_size + capacity * sizeof(type_t))
+		{
+			header = mapping.get<queue_header_t>();
+			slots = mapping.get<type_t>(queue_header_size);
+			acquire_word(header->word);
+			if(header->element_size.load() == 0)
+			{
+				header->element_size.store(sizeof(type_t));
+				header->capacity.store(capacity);
+			}
+			auto const is_valid = header->element_size.load() == sizeof(type_t) and header->capacity.load() == capacity;
+			release_word(header->word);
+			if(!is_valid)
+			{
+				throw std::runtime_error("could not match queue in file \"" + filename + "\" with its element size and capacity");
+			}
+		}
+		
+		auto try_push(type_t const & value)
+		{
+			acquire_word(header->word);
+			auto const tail = header->tail.load();
+			if(tail - header->head.load() >= capacity)
+			{
+				release_word(header->word);
+				return false;
+			}
+			slots[tail % capacity] = value;
+			header->tail.store(tail + 1);
+			release_word(header->word);
+			wake(header->pushed);
+			return true;
+		}
+		
+		auto try_pop()
+		{
+			auto value = std::optional<type_t>();
+			acquire_word(header->word);
+			auto const head = header->head.load();
+			if(head != header->tail.load())
+			{
+				value = slots[head % capacity];
+				header->head.store(head + 1);
+			}
+			release_word(header->word);
+			if(value)
+			{
+				wake(header->popped);
+			}
+			return value;
+		}
+		
+		auto push(type_t const & value)
+		{
+			while(true)
+			{
+				auto const generation = header->popped.load();
+				if(try_push(value))
+				{
+					return;
+				}
+				sleep(header->popped, generation);
+			}
+		}
+		
+		auto pop()
+		{
+			while(true)
+			{
+				auto const generation = header->pushed.load();
+				if(auto value = try_pop())
+				{
+					return *value;
+				}
+				sleep(header->pushed, generation);
+			}
+		}
+		
+		auto size() const
+		{
+			return static_cast<std::size_t>(header->tail.load() - header->head.load());
+		}
+	};
+	
+	class rate_limiter_t
+	{
+		rate_header_t * header = nullptr;
+		std::int64_t interval = 0;
+		std::int64_t tolerance = 0;
+		
+		auto reserve(std::uint64_t const count, bool const should_wait)
+		{
+			auto const cost = interval * static_cast<std::int64_t>(count);
+			auto const now = get_monotonic_time();
+			auto tat = header->tat.load();
+			while(true)
+			{
+				auto const next = std::max(tat, now) + cost;
+				if(next - now > tolerance and !should_wait)
+				{
+					return std::int64_t(-1);
+				}
+				if(header->tat.compare_exchange_weak(tat, next))
+				{
+					return std::max(next - now - tolerance, std::int64_t(0));
+				}
+			}
+		}
+		
+		public:
+		
+		rate_limiter_t(rate_limiter_t const &) = delete;
+		rate_limiter_t(rate_limiter_t &&) = delete;
+		rate_limiter_t & operator=(rate_limiter_t const &) = delete;
+		rate_limiter_t & operator=(rate_limiter_t &&) = delete;
+		
+		rate_limiter_t(std::string const & filename, double const rate, std::uint64_t const burst)
+		{
+			if(!(rate > 0) or burst == 0)
+			{
+				throw std::runtime_error("could not limit rate of file \"" + filename + "\" with a non-positive rate or burst");
+			}
+			interval = std::max(static_cast<std::int64_t>(1e9 / rate), std::int64_t(1));
+			tolerance = interval * static_cast<std::int64_t>(burst);
+			header = get_mapping(get_identity(filename) + ".rate", sizeof(rate_header_t)).get<rate_header_t>();
+			acquire_word(header->word);
+			if(header->interval.load() == 0)
+			{
+				header->interval.store(interval);
+				header->tolerance.store(tolerance);
+			}
+			auto const is_valid = header->interval.load() == interval and header->tolerance.load() == tolerance;
+			release_word(header->word);
+			if(!is_valid)
+			{
+				throw std::runtime_error("could not match rate limiter of file \"" + filename + "\" with its rate and burst");
+			}
+		}
+		
+		auto try_acquire(std::uint64_t const count = 1)
+		{
+			return reserve(count, false) >= 0;
+		}
+		
+		auto acquire(std::uint64_t const count = 1)
+		{
+			if(auto const delay = reserve(count, true); delay > 0)
+			{
+				std::this_thread::sleep_for(std::chrono::nanoseconds(delay));
+			}
+		}
+	};
+	
+	class keyed_t
+	{
+		keyed_header_t * header = nullptr;
+		
+		auto get_slot(std::uint64_t const hash) const
+		{
+			auto const mask = (std::uint64_t(1) << header->depth.load()) - 1;
+			return header->directory[hash & mask].load();
+		}
+		
+		static auto & get_held()
+		{
+			static thread_local auto held = std::map<std::pair<keyed_header_t const *, std::uint32_t>, std::size_t>();
+			static thread_local auto pid = ::getpid();
+			if(pid != ::getpid())
+			{
+				held.clear();
+				pid = ::getpid();
+			}
+			return held;
+		}
+		
+		auto try_reenter(std::uint64_t const hash)
+		{
+			auto & held = get_held();
+			auto const found = held.find(std::make_pair(header, get_slot(hash)));
+			if(found == held.end())
+			{
+				return std::optional<std::uint32_t>();
+			}
+			++found->second;
+			return std::optional<std::uint32_t>(found->first.second);
+		}
+		
+		auto finish_split(std::uint32_t const index)
+		{
+			auto & slot = header->slots[index];
+			auto const depth = slot.local_depth.load();
+			auto const target = slot.split_to.load() - 1;
+			header->count.store(std::max(header->count.load(), target + 1));
+			header->slots[target].local_depth.store(depth + 1);
+			auto const size = std::uint32_t(1) << header->depth.load();
+			for(auto entry = std::uint32_t(0); entry < size; ++entry)
+			{
+				if(header->directory[entry].load() == index and ((entry >> depth) & 1) != 0)
+				{
+					header->directory[entry].store(target);
+				}
+			}
+			slot.split_to.store(0);
+			slot.local_depth.store(depth + 1);
+		}
+		
+		auto split(std::uint32_t const index)
+		{
+			auto & slot = header->slots[index];
+			acquire_word(header->word);
+			auto const depth = slot.local_depth.load();
+			auto const count = header->count.load();
+			if(depth < max_keyed_depth and count < max_keyed_slots)
+			{
+				if(depth == header->depth.load())
+				{
+					auto const size = std::uint32_t(1) << depth;
+					for(auto entry = std::uint32_t(0); entry < size; ++entry)
+					{
+						header->directory[size + entry].store(header->directory[entry].load());
+					}
+					header->depth.store(depth + 1);
+				}
+				slot.split_to.store(count + 1);
+				finish_split(index);
+			}
+			release_word(header->word);
+		}
+		
+		auto contend(std::uint32_t const index, std::uint64_t const hash)
+		{
+			auto & slot = header->slots[index];
+			slot.contentions.fetch_add(1);
+			if(slot.holder.load() != hash)
+			{
+				slot.is_mixed.store(1);
+			}
+		}
+		
+		auto settle(std::uint32_t const index, std::uint64_t const hash)
+		{
+			auto & slot = header->slots[index];
+			if(slot.split_to.load() != 0)
+			{
+				acquire_word(header->word);
+				if(slot.split_to.load() != 0)
+				{
+					finish_split(index);
+				}
+				release_word(header->word);
+			}
+			if(get_slot(hash) == index)
+			{
+				slot.holder.store(hash);
+				return true;
+			}
+			release_word(slot.word);
+			return false;
+		}
+		
+		template <bool should_not_block>
+		auto acquire(std::string_view const key)
+		{
+			auto const hash = get_hash(key);
+			if(auto const index = try_reenter(hash))
+			{
+				return *index;
+			}
+			while(true)
+			{
+				auto const index = get_slot(hash);
+				auto & slot = header->slots[index];
+				if(!try_acquire_word(slot.word))
+				{
+					if constexpr(should_not_block)
+					{
+						throw std::runtime_error("could not lock key \"" + std::string(key) + "\" because it is already locked");
+					}
+					contend(index, hash);
+					acquire_word(slot.word);
+				}
+				if(settle(index, hash))
+				{
+					get_held().emplace(std::make_pair(header, index), 1);
+					return index;
+				}
+			}
+		}
+		
+		auto try_acquire(std::uint64_t const hash, std::uint32_t const contended)
+		{
+			if(auto const index = try_reenter(hash))
+			{
+				return std::make_pair(true, *index);
+			}
+			while(true)
+			{
+				auto const index = get_slot(hash);
+				if(!try_take_word(header->slots[index].word, contended))
+				{
+					contend(index, hash);
+					return std::make_pair(false, index);
+				}
+				if(settle(index, hash))
+				{
+					get_held().emplace(std::make_pair(header, index), 1);
+					return std::make_pair(true, index);
+				}
+			}
+		}
+		
+		auto release(std::uint32_t const index)
+		{
+			auto & held = get_held();
+			if(auto const found = held.find(std::make_pair(header, index)); found != held.end())
+			{
+				if(--found->second > 0)
+				{
+					return;
+				}
+				held.erase(found);
+			}
+			auto & slot = header->slots[index];
+			if(slot.contentions.load() >= keyed_split_threshold)
+			{
+				if(slot.is_mixed.load())
+				{
+					split(index);
+				}
+				slot.contentions.store(0);
+				slot.is_mixed.store(0);
+			}
+			release_word(slot.word);
+		}
+		
+		public:
+		
+		class [[nodiscard]] guard_t
+		{
+			keyed_t & keyed;
+			std::uint32_t index;
+			
+			public:
+			
+			guard_t(guard_t const &) = delete;
+			guard_t(guard_t &&) = delete;
+			guard_t & operator=(guard_t const &) = delete;
+			guard_t & operator=(guard_t &&) = delete;
+			guard_t * operator&() = delete;
+			
+			template <bool should_not_block>
+			guard_t(keyed_t & _keyed, std::string_view const key, std::bool_constant<should_not_block>) : keyed(_keyed), index(keyed.acquire<should_not_block>(key))
+			{
+			}
+			
+			~guard_t()
+			{
+				keyed.release(index);
+			}
+		};
+		
+		class async_t
+		{
+			struct request_t
+			{
+				std::uint64_t hash = 0;
+				std::uint32_t contended = 0;
+				std::function<void()> callback;
+			};
+			
+			keyed_t & keyed;
+			std::vector<request_t> requests;
+			
+			public:
+			
+			async_t(async_t const &) = delete;
+			async_t(async_t &&) = delete;
+			async_t & operator=(async_t const &) = delete;
+			async_t & operator=(async_t &&) = delete;
+			
+			async_t(keyed_t & _keyed) : keyed(_keyed)
+			{
+			}
+			
+			auto lock(std::string_view const key, std::function<void()> callback)
+			{
+				requests.push_back(request_t{get_hash(key), 0, std::move(callback)});
+			}
+			
+			auto get_pending() const
+			{
+				return requests.size();
+			}
+			
+			auto run_once(std::chrono::nanoseconds const timeout = owner_check_interval)
+			{
+				auto granted = std::size_t(0);
+				auto should_retry = false;
+				auto words = std::vector<std::pair<std::atomic<std::uint32_t> *, std::uint32_t>>();
+				for(std::size_t i = 0; i < requests.size();)
+				{
+					auto & request = requests[i];
+					auto const [is_locked, index] = keyed.try_acquire(request.hash, request.contended);
+					if(is_locked)
+					{
+						auto const callback = std::move(request.callback);
+						requests[i] = std::move(requests.back());
+						requests.pop_back();
+						try
+						{
+							callback();
+						}
+						catch(...)
+						{
+							keyed.release(index);
+							throw;
+						}
+						keyed.release(index);
+						++granted;
+						continue;
+					}
+					auto & word = keyed.header->slots[index].word;
+					auto current = word.load();
+					if(current == 0 or ((current & contended_bit) == 0 and !word.compare_exchange_strong(current, current | contended_bit)))
+					{
+						should_retry = true;
+					}
+					else
+					{
+						request.contended = contended_bit;
+						words.emplace_back(&word, current | contended_bit);
+					}
+					++i;
+				}
+				if(granted == 0 and !should_retry)
+				{
+					std::sort(words.begin(), words.end());
+					words.erase(std::unique(words.begin(), words.end()), words.end());
+					wait_words(words, timeout);
+				}
+				return granted;
+			}
+			
+			auto run()
+			{
+				auto granted = std::size_t(0);
+				while(!requests.empty())
+				{
+					granted += run_once();
+				}
+				return granted;
+			}
+		};
+		
+		keyed_t(keyed_t const &) = delete;
+		keyed_t(keyed_t &&) = delete;
+		keyed_t & operator=(keyed_t const &) = delete;
+		keyed_t & operator=(keyed_t &&) = delete;
+		
+		keyed_t(std::string const & filename)
+		{
+			header = get_mapping(get_identity(filename) + ".keyed", sizeof(keyed_header_t)).get<keyed_header_t>();
+			acquire_word(header->word);
+			if(header->count.load() == 0)
+			{
+				header->count.store(1);
+			}
+			release_word(header->word);
+		}
+		
+		template <bool should_not_block = false>
+		auto lock(std::string_view const key)
+		{
+			return guard_t(*this, key, std::bool_constant<should_not_block>());
+		}
+		
+		auto async()
+		{
+			return async_t(*this);
+		}
+		
+		auto get_stripes() const
+		{
+			return static_cast<std::size_t>(header->count.load());
+		}
+	};
+	
+	class epoch_t
+	{
+		std::string filename;
+		epoch_table_t * table = nullptr;
+		epoch_slot_t * slot = nullptr;
+		::pid_t pid = -1;
+		int nesting = 0;
+		std::vector<std::function<void()>> retired;
+		
+		auto claim()
+		{
+			auto const self = static_cast<std::uint32_t>(::getpid());
+			for(auto index = std::uint32_t(0); index < max_epoch_readers; ++index)
+			{
+				auto & candidate = table->slots[index];
+				auto owner = candidate.pid.load();
+				if(owner == 0 or (owner != self and !is_alive(static_cast<::pid_t>(owner))))
+				{
+					if(candidate.pid.compare_exchange_strong(owner, self))
+					{
+						candidate.epoch.store(0);
+						auto count = table->count.load();
+						while(count <= index and !table->count.compare_exchange_weak(count, index + 1));
+						slot = &candidate;
+						pid = ::getpid();
+						nesting = 0;
+						return;
+					}
+				}
+			}
+			throw std::runtime_error("could not register reader of epoch of file \"" + filename + "\" because all slots are taken");
+		}
+		
+		auto enter()
+		{
+			if(pid != ::getpid())
+			{
+				claim();
+			}
+			if(nesting++ == 0)
+			{
+				slot->epoch.store(table->epoch.load());
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+			}
+		}
+		
+		auto leave()
+		{
+			if(--nesting == 0)
+			{
+				slot->epoch.store(0);
+				if(table->waiters.load() > 0)
+				{
+					table->generation.fetch_add(1);
+					futex_wake(table->generation);
+				}
+			}
+		}
+		
+		public:
+		
+		class [[nodiscard]] reader_t
+		{
+			epoch_t & epoch;
+			
+			public:
+			
+			reader_t(reader_t const &) = delete;
+			reader_t(reader_t &&) = delete;
+			reader_t & operator=(reader_t const &) = delete;
+			reader_t & operator=(reader_t &&) = delete;
+			reader_t * operator&() = delete;
+			
+			reader_t(epoch_t & _epoch) : epoch(_epoch)
+			{
+				epoch.enter();
+			}
+			
+			~reader_t()
+			{
+				epoch.leave();
+			}
+		};
+		
+		epoch_t(epoch_t const &) = delete;
+		epoch_t(epoch_t &&) = delete;
+		epoch_t & operator=(epoch_t const &) = delete;
+		epoch_t & operator=(epoch_t &&) = delete;
+		
+		epoch_t(std::string const & _filename) : filename(_filename)
+		{
+			table = get_mapping(get_identity(filename) + ".epoch", sizeof(epoch_table_t)).get<epoch_table_t>();
+			auto expected = std::uint64_t(0);
+			table->epoch.compare_exchange_strong(expected, 1);
+		}
+		
+		~epoch_t()
+		{
+			if(slot != nullptr and pid == ::getpid())
+			{
+				slot->epoch.store(0);
+				slot->pid.store(0);
+			}
+		}
+
+		auto read()
+		{
+			return reader_t(*this);
+		}
+		
+		auto synchronize()
+		{
+			if(pid == ::getpid() and nesting > 0)
+			{
+				throw std::runtime_error("could not synchronize epoch of file \"" + filename + "\" inside a read section");
+			}
+			auto const target = table->epoch.fetch_add(1) + 1;
+			auto const count = table->count.load();
+			for(auto index = std::uint32_t(0); index < count; ++index)
+			{
+				auto & reader = table->slots[index];
+				while(true)
+				{
+					auto value = reader.epoch.load();
+					if(value == 0 or value >= target)
+					{
+						break;
+					}
+					auto const owner = reader.pid.load();
+					if(owner == 0 or !is_alive(static_cast<::pid_t>(owner)))
+					{
+						reader.epoch.compare_exchange_strong(value, 0);
+						continue;
+					}
+					auto const generation = table->generation.load();
+					table->waiters.fetch_add(1);
+					if(reader.epoch.load() == value)
+					{
+						futex_wait(table->generation, generation, owner_check_interval);
+					}
+					table->waiters.fetch_sub(1);
+				}
+			}
+		}
+		
+		auto retire(std::function<void()> callback)
+		{
+			retired.push_back(std::move(callback));
+		}
+		
+		auto reclaim()
+		{
+			auto callbacks = std::move(retired);
+			retired.clear();
+			synchronize();
+			for(auto & callback : callbacks)
+			{
+				callback();
+			}
+			return callbacks.size();
+		}
+	};
+	
+	class appender_t
+	{
+		std::string filename;
+		append_header_t * header = nullptr;
+		sync_policy_t policy;
+		int descriptor = -1;
+		std::uint32_t generation = 0;
+		std::size_t pending = 0;
+		std::int64_t synced_at = 0;
+		
+		auto flush()
+		{
+			if(pending > 0)
+			{
+				if(::fdatasync(descriptor) < 0)
+				{
+					throw std::runtime_error("could not fdatasync file \"" + filename + "\"");
+				}
+				pending = 0;
+			}
+			synced_at = get_monotonic_time();
+		}
+		
+		auto open()
+		{
+			generation = header->generation.load();
+			::mode_t mask = ::umask(0);
+			int const new_descriptor = ::open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0666);
+			::umask(mask);
+			if(new_descriptor < 0)
+			{
+				throw std::runtime_error("could not open file \"" + filename + "\" for appending");
+			}
+			if(descriptor >= 0)
+			{
+				flush();
+				::close(descriptor);
+			}
+			descriptor = new_descriptor;
+		}
+		
+		public:
+		
+		appender_t(appender_t const &) = delete;
+		appender_t(appender_t &&) = delete;
+		appender_t & operator=(appender_t const &) = delete;
+		appender_t & operator=(appender_t &&) = delete;
+		
+		appender_t(std::string const & _filename, sync_policy_t const & _policy) : filename(_filename), policy(_policy)
+		{
+			header = get_mapping("/dev/shm/locker.append." + get_path_hash(filename), sizeof(append_header_t)).get<append_header_t>();
+			synced_at = get_monotonic_time();
+			open();
+		}
+		
+		~appender_t()
+		{
+			try
+			{
+				flush();
+			}
+			catch(...)
+			{
+			}
+			::close(descriptor);
+		}
+		
+		auto append(std::string_view const record)
+		{
+			if(header->generation.load(std::memory_order_relaxed) != generation)
+			{
+				open();
+			}
+			auto const size = ::write(descriptor, record.data(), record.size());
+			if(size != static_cast<::ssize_t>(record.size()))
+			{
+				throw std::runtime_error("could not append " + std::to_string(record.size()) + " bytes to file \"" + filename + "\"");
+			}
+			++pending;
+			if(pending >= policy.max_records or (policy.max_delay != std::chrono::nanoseconds::max() and get_monotonic_time() - synced_at >= policy.max_delay.count()))
+			{
+				flush();
+			}
+		}
+		
+		auto sync()
+		{
+			flush();
+		}
+		
+		auto lock()
+		{
+			return lock_guard_t<false, true>(filename);
+		}
+		
+		auto rotate(std::string const & target)
+		{
+			{
+				auto const guard = lock();
+				flush();
+				if(::rename(filename.c_str(), target.c_str()) < 0)
+				{
+					throw std::runtime_error("could not rename file \"" + filename + "\" to \"" + target + "\"");
+				}
+				header->generation.fetch_add(1);
+			}
+			open();
+		}
+		
+		auto truncate()
+		{
+			auto const guard = lock();
+			if(header->generation.load() != generation)
+			{
+				open();
+			}
+			if(::truncate(filename.c_str(), 0) < 0)
+			{
+				throw std::runtime_error("could not truncate file \"" + filename + "\"");
+			}
+			pending = 0;
+		}
+	};
+	
+	template <typename type_t>
+	struct offset_t
+	{
+		std::uint64_t value = 0;
+		
+		explicit operator bool() const
+		{
+			return value != 0;
+		}
+	};
+	
+	class arena_t
+	{
+		std::string filename;
+		int descriptor = -1;
+		void * address = nullptr;
+		std::size_t length = 0;
+		
+		auto get_header() const
+		{
+			return static_cast<arena_header_t *>(address);
+		}
+		
+		auto remap(std::size_t const size)
+		{
+			if(address)
+			{
+				::munmap(address, length);
+				address = nullptr;
+			}
+			address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+			if(address == MAP_FAILED)
+			{
+				address = nullptr;
+				throw std::runtime_error("could not map file \"" + filename + "\"");
+			}
+			length = size;
+		}
+		
+		auto grow(std::size_t const needed)
+		{
+			auto size = length;
+			while(size < needed)
+			{
+				size *= 2;
+			}
+			if(::ftruncate(descriptor, static_cast<::off_t>(size)) < 0)
+			{
+				throw std::runtime_error("could not grow file \"" + filename + "\"");
+			}
+			remap(size);
+			get_header()->size = size;
+		}
+		
+		auto refresh()
+		{
+			if(get_header()->size > length)
+			{
+				remap(get_header()->size);
+			}
+		}
+		
+		public:
+		
+		arena_t(arena_t const &) = delete;
+		arena_t(arena_t &&) = delete;
+		arena_t & operator=(arena_t const &) = delete;
+		arena_t & operator=(arena_t &&) = delete;
+		
+		class [[nodiscard]] guard_t
+		{
+			lock_guard_t<false, true> guard;
+			
+			public:
+			
+			guard_t(guard_t const &) = delete;
+			guard_t(guard_t &&) = delete;
+			guard_t & operator=(guard_t const &) = delete;
+			guard_t & operator=(guard_t &&) = delete;
+			guard_t * operator&() = delete;
+			
+			guard_t(arena_t & arena) : guard(arena.filename)
+			{
+				arena.refresh();
+			}
+		};
+		
+		arena_t(std::string const & _filename) : filename(_filename)
+		{
+			auto const guard = lock_guard_t<false, true>(filename);
+			descriptor = ::open(filename.c_str(), O_RDWR | O_CLOEXEC);
+			struct ::stat status;
+			if(descriptor < 0 or ::fstat(descriptor, &status) < 0)
+			{
+				if(descriptor >= 0)
+				{
+					::close(descriptor);
+				}
+				throw std::runtime_error("could not open file \"" + filename + "\" for arena");
+			}
+			if(static_cast<std::size_t>(status.st_size) < arena_initial_size)
+			{
+				if(status.st_size != 0 or ::ftruncate(descriptor, static_cast<::off_t>(arena_initial_size)) < 0)
+				{
+					::close(descriptor);
+					throw std::runtime_error("could not initialize arena in file \"" + filename + "\"");
+				}
+				status.st_size = static_cast<::off_t>(arena_initial_size);
+			}
+			try
+			{
+				remap(static_cast<std::size_t>(status.st_size));
+			}
+			catch(...)
+			{
+				::close(descriptor);
+				throw;
+			}
+			auto & header = *get_header();
+			if(header.magic == 0)
+			{
+				header.size = length;
+				header.top = arena_header_size;
+				header.magic = arena_magic;
+			}
+			if(header.magic != arena_magic)
+			{
+				::munmap(address, length);
+				::close(descriptor);
+				throw std::runtime_error("could not find arena in file \"" + filename + "\"");
+			}
+		}
+		
+		~arena_t()
+		{
+			if(address)
+			{
+				::munmap(address, length);
+			}
+			::close(descriptor);
+		}
+		
+		auto lock()
+		{
+			return guard_t(*this);
+		}
+		
+		template <typename object_t>
+		auto get(offset_t<object_t> const offset) const
+		{
+			return static_cast<object_t *>(static_cast<void *>(static_cast<char *>(address) + offset.value));
+		}
+		
+		template <typename object_t>
+		auto get_offset(object_t const * object) const
+		{
+			return offset_t<object_t>{static_cast<std::uint64_t>(static_cast<char const *>(static_cast<void const *>(object)) - static_cast<char const *>(address))};
+		}
+		
+		template <typename object_t>
+		auto allocate(std::size_t const count = 1)
+		{
+			static_assert(alignof(object_t) <= arena_block_header);
+			auto const size = count * sizeof(object_t) + arena_block_header;
+			auto size_class = arena_min_class;
+			while((std::size_t(1) << size_class) < size)
+			{
+				++size_class;
+			}
+			if(size_class > arena_max_class)
+			{
+				throw std::runtime_error("could not allocate " + std::to_string(size) + " bytes in arena \"" + filename + "\"");
+			}
+			auto * header = get_header();
+			auto block = header->free_lists[size_class];
+			if(block)
+			{
+				header->free_lists[size_class] = *static_cast<std::uint64_t *>(static_cast<void *>(static_cast<char *>(address) + block + arena_block_header));
+			}
+			else
+			{
+				block = header->top;
+				auto const needed = block + (std::size_t(1) << size_class);
+				if(needed > length)
+				{
+					grow(needed);
+					header = get_header();
+				}
+				header->top = needed;
+			}
+			*static_cast<std::uint64_t *>(static_cast<void *>(static_cast<char *>(address) + block)) = size_class;
+			auto const offset = offset_t<object_t>{block + arena_block_header};
+			std::memset(static_cast<void *>(get(offset)), 0, (std::size_t(1) << size_class) - arena_block_header);
+			return offset;
+		}
+		
+		template <typename object_t>
+		auto deallocate(offset_t<object_t> const offset)
+		{
+			if(!offset)
+			{
+				return;
+			}
+			auto const block = offset.value - arena_block_header;
+			auto const size_class = *static_cast<std::uint64_t *>(static_cast<void *>(static_cast<char *>(address) + block));
+			auto * header = get_header();
+			*static_cast<std::uint64_t *>(static_cast<void *>(static_cast<char *>(address) + offset.value)) = header->free_lists[size_class];
+			header->free_lists[size_class] = block;
+		}
+		
+		template <typename object_t>
+		auto get_root() const
+		{
+			return offset_t<object_t>{get_header()->root};
+		}
+		
+		template <typename object_t>
+		auto set_root(offset_t<object_t> const offset)
+		{
+			get_header()->root = offset.value;
+		}
+		
+		template <typename element_t>
+		class vector_t
+		{
+			static_assert(std::is_trivially_copyable_v<element_t>);
+			
+			offset_t<element_t> data;
+			std::uint64_t count = 0;
+			std::uint64_t capacity = 0;
+			
+			public:
+			
+			auto size() const
+			{
+				return static_cast<std::size_t>(count);
+			}
+			
+			auto get(arena_t const & arena) const
+			{
+				return arena.get(data);
+			}
+			
+			auto & at(arena_t const & arena, std::size_t const index) const
+			{
+				if(index >= count)
+				{
+					throw std::out_of_range("could not access arena vector at index " + std::to_string(index));
+				}
+				return get(arena)[index];
+			}
+			
+			auto reserve(arena_t & arena, std::size_t const new_capacity)
+			{
+				if(new_capacity <= capacity)
+				{
+					return;
+				}
+				auto const self = arena.get_offset(this);
+				auto const new_data = arena.template allocate<element_t>(new_capacity);
+				auto & vector = *arena.get(self);
+				if(vector.count > 0)
+				{
+					std::memcpy(static_cast<void *>(arena.get(new_data)), static_cast<void const *>(arena.get(vector.data)), vector.count * sizeof(element_t));
+				}
+				arena.deallocate(vector.data);
+				vector.data = new_data;
+				vector.capacity = new_capacity;
+			}
+			
+			auto push_back(arena_t & arena, element_t const & value)
+			{
+				auto const self = arena.get_offset(this);
+				auto const copy = value;
+				if(count == capacity)
+				{
+					reserve(arena, capacity ? 2 * capacity : 4);
+				}
+				auto & vector = *arena.get(self);
+				vector.get(arena)[vector.count++] = copy;
+			}
+			
+			auto resize(arena_t & arena, std::size_t const new_count)
+			{
+				auto const self = arena.get_offset(this);
+				reserve(arena, new_count);
+				auto & vector = *arena.get(self);
+				if(new_count > vector.count)
+				{
+					std::memset(static_cast<void *>(vector.get(arena) + vector.count), 0, (new_count - vector.count) * sizeof(element_t));
+				}
+				vector.count = new_count;
+			}
+			
+			auto clear()
+			{
+				count = 0;
+			}
+		};
+		
+		class string_t : public vector_t<char>
+		{
+			public:
+			
+			auto assign(arena_t & arena, std::string_view const text)
+			{
+				auto const self = arena.get_offset(this);
+				resize(arena, text.size());
+				auto & string = *arena.get(self);
+				if(!text.empty())
+				{
+					std::memcpy(string.get(arena), text.data(), text.size());
+				}
+			}
+			
+			auto view(arena_t const & arena) const
+			{
+				return std::string_view(get(arena), size());
+			}
+		};
+	};
+	
+	class snapshot_t
+	{
+		std::string filename;
+		
+		auto get_version_filename(std::uint64_t const version) const
 		{
-			id = lock<should_not_block>(filename).first;
+			return filename + "." + std::to_string(version);
 		}
 		
-		~lock_guard_t()
+		auto read_version() const
+		{
+			auto version = std::uint64_t(0);
+			int descriptor = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+			if(descriptor >= 0)
+			{
+				char text[32] = {};
+				if(::read(descriptor, text, sizeof(text) - 1) > 0)
+				{
+					version = std::strtoull(text, nullptr, 10);
+				}
+				::close(descriptor);
+			}
+			return version;
+		}
+		
+		public:
+		
+		snapshot_t(snapshot_t const &) = delete;
+		snapshot_t(snapshot_t &&) = delete;
+		snapshot_t & operator=(snapshot_t const &) = delete;
+		snapshot_t & operator=(snapshot_t &&) = delete;
+		
+		class [[nodiscard]] pin_t
+		{
+			key_t id;
+			std::uint64_t generation = 0;
+			std::uint64_t version = 0;
+			std::string version_filename;
+			
+			public:
+			
+			pin_t(pin_t const &) = delete;
+			pin_t(pin_t &&) = delete;
+			pin_t & operator=(pin_t const &) = delete;
+			pin_t & operator=(pin_t &&) = delete;
+			pin_t * operator&() = delete;
+			
+			pin_t(snapshot_t const & snapshot)
+			{
+				while(true)
+				{
+					version = snapshot.read_version();
+					if(version == 0)
+					{
+						throw std::runtime_error("could not find a version of snapshot \"" + snapshot.filename + "\"");
+					}
+					version_filename = snapshot.get_version_filename(version);
+					try
+					{
+						auto const [key, lockfile] = lock<false, true>(version_filename, O_RDONLY);
+						id = key;
+						generation = lockfile.generation;
+						return;
+					}
+					catch(...)
+					{
+						if(snapshot.read_version() == version)
+						{
+							throw;
+						}
+					}
+				}
+			}
+			
+			~pin_t()
+			{
+				unlock<true>(id, generation);
+			}
+			
+			auto get_version() const
+			{
+				return version;
+			}
+			
+			auto const & get_filename() const
+			{
+				return version_filename;
+			}
+		};
+		
+		snapshot_t(std::string const & _filename) : filename(_filename)
+		{
+		}
+		
+		auto pin() const
+		{
+			return pin_t(*this);
+		}
+		
+		template <typename writer_t>
+		auto publish(writer_t && write)
+		{
+			auto const temporary = get_temporary_filename(filename);
+			try
+			{
+				write(temporary);
+			}
+			catch(...)
+			{
+				::unlink(temporary.c_str());
+				throw;
+			}
+			auto version = std::uint64_t(0);
+			{
+				auto const guard = lock_guard_t(filename);
+				version = read_version() + 1;
+				if(::rename(temporary.c_str(), get_version_filename(version).c_str()) < 0)
+				{
+					::unlink(temporary.c_str());
+					throw std::runtime_error("could not publish version " + std::to_string(version) + " of snapshot \"" + filename + "\"");
+				}
+				write_file(filename, std::to_string(version));
+			}
+			reclaim();
+			return version;
+		}
+		
+		auto reclaim()
 		{
-			unlock<should_keep_trace>(id);
+			auto const current = read_version();
+			auto const path = std::filesystem::path(filename);
+			auto const directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+			auto const prefix = path.filename().string() + ".";
+			auto error = std::error_code();
+			for(auto const & entry : std::filesystem::directory_iterator(directory, error))
+			{
+				auto const name = entry.path().filename().string();
+				if(!name.starts_with(prefix) or name.size() == prefix.size() or name.find_first_not_of("0123456789", prefix.size()) != std::string::npos)
+				{
+					continue;
+				}
+				auto const version = std::strtoull(name.c_str() + prefix.size(), nullptr, 10);
+				if(version >= current)
+				{
+					continue;
+				}
+				int descriptor = ::open(get_version_filename(version).c_str(), O_RDONLY | O_CLOEXEC);
+				if(descriptor < 0)
+				{
+					continue;
+				}
+				if(::flock(descriptor, LOCK_EX | LOCK_NB) == 0)
+				{
+					::unlink(get_version_filename(version).c_str());
+				}
+				::close(descriptor);
+			}
 		}
 	};
 	
@@ -316,10 +3668,345 @@ class locker
 		return lock_guard_t(filename);
 	}
 
+	static auto lock_guard(std::string const & filename, prefetch_t const & hint)
+	{
+		return lock_guard_t(filename, hint);
+	}
+	
+	static auto lock_with_backoff(std::string const & filename)
+	{
+		return lock_guard_t<true>(filename, backoff_t());
+	}
+	
+	static auto lock_with_backoff(std::string const & filename, backoff_t const & policy)
+	{
+		return lock_guard_t<true>(filename, policy);
+	}
+	
+	template <typename policy_t>
+	static auto lock_with_backoff(std::string const & filename, policy_t && policy)
+	{
+		return lock_guard_t<true>(filename, std::forward<policy_t>(policy));
+	}
+	
 	static auto try_lock_guard(std::string const & filename)
 	{
 		return lock_guard_t<true>(filename);
 	}
+	
+	static auto batch_lock_guard(std::vector<std::string> const & filenames)
+	{
+		return batch_guard_t(filenames);
+	}
+	
+	template <bool should_not_block = false>
+	static auto directory_lock_guard(std::string const & dirname)
+	{
+		return lock_guard_t<should_not_block>(dirname, directory_t());
+	}
+	
+	static auto lock_chain(std::vector<std::string> const & filenames)
+	{
+		return chain_t(filenames);
+	}
+	
+	static auto shared_lock_guard(std::string const & filename)
+	{
+		return lock_guard_t<false, false, true>(filename);
+	}
+	
+	static auto priority_lock_guard(std::string const & filename, int const priority)
+	{
+		return lock_guard_t(filename, priority);
+	}
+	
+	static auto cohort_guard(std::string const & filename)
+	{
+		return cohort_guard_t(filename);
+	}
+	
+	static auto read_cache(std::string const & filename)
+	{
+		return read_cache_t(filename);
+	}
+	
+	static auto snapshot(std::string const & filename)
+	{
+		return snapshot_t(filename);
+	}
+	
+	template <typename type_t, std::size_t capacity>
+	static auto queue(std::string const & filename)
+	{
+		return queue_t<type_t, capacity>(filename);
+	}
+	
+	static auto rate_limiter(std::string const & filename, double const rate, std::uint64_t const burst)
+	{
+		return rate_limiter_t(filename, rate, burst);
+	}
+	
+	static auto keyed(std::string const & filename)
+	{
+		return keyed_t(filename);
+	}
+	
+	static auto epoch(std::string const & filename)
+	{
+		return epoch_t(filename);
+	}
+	
+	static auto set_teardown(teardown_t const mode)
+	{
+		get_singleton().teardown.store(static_cast<int>(mode));
+	}
+	
+	static auto release_all()
+	{
+		auto & singleton = get_singleton();
+		auto const guard = std::scoped_lock<std::mutex>(singleton.mtx);
+		singleton.release_lockfiles();
+	}
+	
+	static auto appender(std::string const & filename)
+	{
+		return appender_t(filename, sync_policy_t());
+	}
+	
+	static auto appender(std::string const & filename, sync_policy_t const & policy)
+	{
+		return appender_t(filename, policy);
+	}
+	
+	static auto set_estimating(bool const should_estimate)
+	{
+		get_singleton().is_estimating.store(should_estimate);
+	}
+	
+	static auto estimate_wait(std::string const & filename)
+	{
+		auto const name = get_stats_name(filename);
+		struct ::stat status;
+		if(::stat(name.c_str(), &status) < 0)
+		{
+			return std::chrono::nanoseconds(0);
+		}
+		auto const & stats = *get_mapping(name, sizeof(stats_t)).get<stats_t>();
+		auto const hold_time = stats.hold_time.load();
+		auto const now = get_monotonic_time();
+		auto remaining = std::int64_t(0);
+		auto waiters = std::int64_t(0);
+		for(auto const & slot : stats.slots)
+		{
+			auto const owner = slot.pid.load();
+			auto const slot_waiters = slot.waiters.load();
+			auto const acquired_at = slot.acquired_at.load();
+			if(owner == 0 or (slot_waiters == 0 and acquired_at == 0) or !is_alive(static_cast<::pid_t>(owner)))
+			{
+				continue;
+			}
+			waiters += slot_waiters;
+			if(acquired_at != 0)
+			{
+				remaining = std::max(remaining, hold_time - (now - acquired_at));
+			}
+		}
+		return std::chrono::nanoseconds(remaining + waiters * hold_time);
+	}
+	
+	static auto set_profiling(bool const should_profile)
+	{
+		get_singleton().is_profiling.store(should_profile);
+	}
+	
+	static auto get_profile(std::string const & filename)
+	{
+		auto & singleton = get_singleton();
+		auto const guard = std::scoped_lock<std::mutex>(singleton.mtx);
+		auto const path = get_normal_path(filename);
+		return singleton.profiles.contains(path) ? singleton.profiles.at(path) : profile_t();
+	}
+	
+	static auto get_profiles()
+	{
+		auto & singleton = get_singleton();
+		auto const guard = std::scoped_lock<std::mutex>(singleton.mtx);
+		return singleton.profiles;
+	}
+	
+	template <typename function_t>
+	static auto call_once(std::string const & filename, function_t && function)
+	{
+		struct ::stat status;
+		if(::stat(filename.c_str(), &status) == 0 and status.st_size > 0)
+		{
+			return false;
+		}
+		auto const [id, lockfile] = lock<false>(filename);
+		try
+		{
+			if(::fstat(lockfile.descriptor, &status) < 0)
+			{
+				throw std::runtime_error("could not get status of file \"" + filename + "\"");
+			}
+			auto const should_call = status.st_size == 0;
+			if(should_call)
+			{
+				function();
+				if(::pwrite(lockfile.descriptor, "1", 1, 0) != 1)
+				{
+					throw std::runtime_error("could not mark file \"" + filename + "\" as called");
+				}
+			}
+			unlock<false>(id, lockfile.generation);
+			return should_call;
+		}
+		catch(...)
+		{
+			unlock<false>(id, lockfile.generation);
+			throw;
+		}
+	}
+	
+	template <typename compute_t>
+	static auto single_flight(std::string const & filename, compute_t && compute)
+	{
+		auto const flight = filename + ".flight";
+		if(auto contents = read_file(filename))
+		{
+			return *contents;
+		}
+		auto & singleton = get_singleton();
+		auto const path = get_normal_path(filename);
+		auto gate = std::shared_ptr<std::mutex>();
+		{
+			auto const guard = std::scoped_lock<std::mutex>(singleton.flight_mtx);
+			auto & entry = singleton.flights[path];
+			if(!entry)
+			{
+				entry = std::make_shared<std::mutex>();
+			}
+			gate = entry;
+		}
+		auto const leave = [&]()
+		{
+			auto const guard = std::scoped_lock<std::mutex>(singleton.flight_mtx);
+			if(gate.use_count() == 2)
+			{
+				singleton.flights.erase(path);
+			}
+		};
+		try
+		{
+			auto const result = [&]()
+			{
+				auto const passenger = std::scoped_lock<std::mutex>(*gate);
+				if(auto contents = read_file(filename))
+				{
+					return *contents;
+				}
+				wait_unlocked(flight);
+				if(auto contents = read_file(filename))
+				{
+					return *contents;
+				}
+				auto const guard = lock_guard_t(flight);
+				if(auto contents = read_file(filename))
+				{
+					return *contents;
+				}
+				auto const contents = std::string(compute());
+				write_file(filename, contents);
+				return contents;
+			}();
+			leave();
+			return result;
+		}
+		catch(...)
+		{
+			leave();
+			throw;
+		}
+	}
+	
+	static auto wait_unlocked(std::string const & filename, std::chrono::milliseconds const timeout = std::chrono::milliseconds(-1))
+	{
+		if(is_held(filename))
+		{
+			throw std::runtime_error("could not wait for file \"" + filename + "\" locked by this process");
+		}
+		int notifier = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+		if(notifier < 0)
+		{
+			throw std::runtime_error("could not watch file \"" + filename + "\"");
+		}
+		int probe = -1;
+		auto const deadline = std::chrono::steady_clock::now() + timeout;
+		auto const cleanup = [&]()
+		{
+			if(probe >= 0)
+			{
+				::close(probe);
+			}
+			::close(notifier);
+		};
+		auto const is_unlocked = [&]()
+		{
+			if(::flock(probe, LOCK_SH | LOCK_NB) < 0)
+			{
+				return false;
+			}
+			::flock(probe, LOCK_UN);
+			return true;
+		};
+		while(true)
+		{
+			if(probe < 0)
+			{
+				probe = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+				if(probe < 0 or ::inotify_add_watch(notifier, filename.c_str(), IN_CLOSE_WRITE | IN_CLOSE_NOWRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF) < 0)
+				{
+					cleanup();
+					return true;
+				}
+			}
+			if(is_unlocked())
+			{
+				cleanup();
+				return true;
+			}
+			auto interval = std::int64_t(owner_check_interval.count());
+			if(timeout.count() >= 0)
+			{
+				auto const remaining = std::int64_t(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count());
+				if(remaining <= 0)
+				{
+					cleanup();
+					return false;
+				}
+				interval = std::min(interval, remaining);
+			}
+			auto notification = ::pollfd{notifier, POLLIN, 0};
+			if(::poll(&notification, 1, static_cast<int>(interval)) <= 0)
+			{
+				continue;
+			}
+			char events[4096];
+			while(::read(notifier, events, sizeof(events)) > 0);
+			struct ::stat descriptor_status;
+			struct ::stat filename_status;
+			if(::fstat(probe, &descriptor_status) < 0 or ::stat(filename.c_str(), &filename_status) < 0 or descriptor_status.st_ino != filename_status.st_ino or descriptor_status.st_dev != filename_status.st_dev)
+			{
+				if(is_unlocked())
+				{
+					cleanup();
+					return true;
+				}
+				::close(probe);
+				probe = -1;
+			}
+		}
+	}
 };
 
 #endif
@@ -18,20 +18,389 @@
 // 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <signal.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <thread>
 
+static unsigned cohort_node = 0;
+
+#define LOCKER_NUMA_NODE(node) cohort_node
+
 #include "locker.hpp"
 
 #define NUM_FORKS 50
 
+static auto can_child_lock(std::string const & filename)
+{
+	auto const pid = ::fork();
+	if(pid == 0)
+	{
+		try
+		{
+			auto const guard = locker::try_lock_guard(filename);
+			std::_Exit(EXIT_SUCCESS);
+		}
+		catch(...)
+		{
+			std::_Exit(EXIT_FAILURE);
+		}
+	}
+	int status = 0;
+	::waitpid(pid, &status, 0);
+	return WIFEXITED(status) and WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+template <typename function_t>
+static auto spawn(function_t const & function)
+{
+	auto const pid = ::fork();
+	if(pid < 0)
+	{
+		throw std::runtime_error("fork did not work");
+	}
+	else if(pid == 0)
+	{
+		function();
+		std::_Exit(EXIT_SUCCESS);
+	}
+	return pid;
+}
+
+static auto test_cohort_takeover()
+{
+	std::string const filename = "test.cohort";
+	std::ofstream(filename) << "cohort";
+	auto * const flags = static_cast<std::atomic<int> *>(::mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+	auto & is_passed = flags[0];
+	auto & is_inside = flags[1];
+	auto & violations = flags[2];
+	auto const wait_for = [](std::atomic<int> const & flag)
+	{
+		while(flag.load() == 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	};
+	auto const passer = spawn([&]()
+	{
+		auto const guard = locker::cohort_guard(filename);
+		is_inside.store(1);
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		is_inside.store(0);
+	});
+	wait_for(is_inside);
+	auto const adopter = spawn([&]()
+	{
+		auto const guard = locker::cohort_guard(filename);
+		is_passed.store(1);
+		::pause();
+	});
+	wait_for(is_passed);
+	::kill(adopter, SIGKILL);
+	::waitpid(adopter, nullptr, 0);
+	::waitpid(passer, nullptr, 0);
+	auto const other = spawn([&]()
+	{
+		cohort_node = 1;
+		auto const guard = locker::cohort_guard(filename);
+		is_inside.store(1);
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		is_inside.store(0);
+	});
+	wait_for(is_inside);
+	auto const successor = spawn([&]()
+	{
+		auto const guard = locker::cohort_guard(filename);
+		if(is_inside.load() != 0)
+		{
+			violations.fetch_add(1);
+		}
+	});
+	::waitpid(successor, nullptr, 0);
+	::waitpid(other, nullptr, 0);
+	auto const is_exclusive = violations.load() == 0;
+	::munmap(flags, 4096);
+	struct ::stat status;
+	if(::stat(filename.c_str(), &status) == 0)
+	{
+		auto const name = "/dev/shm/locker." + std::to_string(status.st_dev) + "." + std::to_string(status.st_ino) + ".cohort";
+		for(auto const & suffix : {"", ".0", ".1"})
+		{
+			std::remove((name + suffix).c_str());
+		}
+	}
+	std::remove(filename.c_str());
+	std::cout << "cohort guard " << (is_exclusive ? "stayed exclusive" : "had two holders") << " after a killed holder was taken over from another node" << std::endl;
+	return is_exclusive;
+}
+
+static auto test_shared_upgrade()
+{
+	std::string const filename = "test.upgrade";
+	auto is_kept = false;
+	int ready[2];
+	int done[2];
+	if(::pipe(ready) < 0 or ::pipe(done) < 0)
+	{
+		throw std::runtime_error("pipe did not work");
+	}
+	auto const reader = ::fork();
+	if(reader == 0)
+	{
+		auto const shared = locker::shared_lock_guard(filename);
+		char byte = 0;
+		if(::write(ready[1], &byte, 1) < 0 or ::read(done[0], &byte, 1) < 0)
+		{
+			std::_Exit(EXIT_FAILURE);
+		}
+		std::_Exit(EXIT_SUCCESS);
+	}
+	char byte = 0;
+	if(::read(ready[0], &byte, 1) < 0)
+	{
+		throw std::runtime_error("read did not work");
+	}
+	{
+		auto const shared = locker::shared_lock_guard(filename);
+		try
+		{
+			auto const exclusive = locker::try_lock_guard(filename);
+		}
+		catch(...)
+		{
+		}
+		if(::write(done[1], &byte, 1) < 0)
+		{
+			throw std::runtime_error("write did not work");
+		}
+		::waitpid(reader, nullptr, 0);
+		is_kept = !can_child_lock(filename);
+	}
+	for(auto const descriptor : {ready[0], ready[1], done[0], done[1]})
+	{
+		::close(descriptor);
+	}
+	std::remove(filename.c_str());
+	std::cout << "shared lock " << (is_kept ? "kept" : "lost") << " after a refused upgrade" << std::endl;
+	return is_kept;
+}
+
+static auto test_release_all()
+{
+	std::string const filename = "test.release";
+	auto const child = spawn([&]()
+	{
+		auto stale = std::optional<locker::lock_guard_t<>>();
+		stale.emplace(filename);
+		locker::release_all();
+		auto const fresh = locker::lock_guard(filename);
+		stale.reset();
+		auto const is_kept = !can_child_lock(filename);
+		std::_Exit(is_kept ? EXIT_SUCCESS : EXIT_FAILURE);
+	});
+	int status = 0;
+	::waitpid(child, &status, 0);
+	std::remove(filename.c_str());
+	auto const is_kept = WIFEXITED(status) and WEXITSTATUS(status) == EXIT_SUCCESS;
+	std::cout << "lock " << (is_kept ? "kept" : "lost") << " when a guard from before release_all went out of scope" << std::endl;
+	return is_kept;
+}
+
+static auto remove_shared(std::string const & filename, std::string const & suffix)
+{
+	struct ::stat status;
+	if(::stat(filename.c_str(), &status) == 0)
+	{
+		std::remove(("/dev/shm/locker." + std::to_string(status.st_dev) + "." + std::to_string(status.st_ino) + suffix).c_str());
+	}
+	std::remove(filename.c_str());
+}
+
+static auto test_keyed_split()
+{
+	std::string const filename = "test.keys";
+	remove_shared(filename, ".keyed");
+	auto * const flags = static_cast<std::atomic<int> *>(::mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+	auto * const inside = flags;
+	auto * const counts = flags + 16;
+	auto & violations = flags[32];
+	auto & ready = flags[33];
+	auto is_reentered = false;
+	{
+		auto my_keys = locker::keyed(filename);
+		{
+			auto const outer = my_keys.lock("a");
+			{
+				auto const inner = my_keys.lock("b");
+			}
+			is_reentered = my_keys.get_stripes() == 1;
+			auto const child = spawn([&]()
+			{
+				try
+				{
+					auto const busy = my_keys.lock<true>("a");
+				}
+				catch(...)
+				{
+					std::_Exit(EXIT_FAILURE);
+				}
+			});
+			int status = 0;
+			::waitpid(child, &status, 0);
+			is_reentered = is_reentered and WIFEXITED(status) and WEXITSTATUS(status) == EXIT_FAILURE;
+		}
+		pid_t children[8];
+		for(auto i = 0; i < 8; ++i)
+		{
+			children[i] = spawn([&, i]()
+			{
+				ready.fetch_add(1);
+				while(ready.load() < 8)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				for(auto j = 0; j < 500; ++j)
+				{
+					auto const key = (i + j) % 16;
+					{
+						auto const guard = my_keys.lock("key" + std::to_string(key));
+						if(inside[key].exchange(1) != 0)
+						{
+							violations.fetch_add(1);
+						}
+						auto const count = counts[key].load();
+						std::this_thread::sleep_for(std::chrono::microseconds(10));
+						counts[key].store(count + 1);
+						inside[key].store(0);
+					}
+					std::this_thread::sleep_for(std::chrono::microseconds(10));
+				}
+			});
+		}
+		for(auto const child : children)
+		{
+			::waitpid(child, nullptr, 0);
+		}
+		auto total = 0;
+		for(auto key = 0; key < 16; ++key)
+		{
+			total += counts[key].load();
+		}
+		auto const stripes = my_keys.get_stripes();
+		auto const is_exclusive = violations.load() == 0 and total == 8 * 500 and stripes > 1;
+		std::cout << "keyed locks " << (is_reentered ? "re-entered" : "did not re-enter") << " a held stripe and " << (is_exclusive ? "stayed exclusive" : "lost updates") << " while splitting into " << stripes << " stripes" << std::endl;
+		is_reentered = is_reentered and is_exclusive;
+	}
+	::munmap(flags, 4096);
+	remove_shared(filename, ".keyed");
+	return is_reentered;
+}
+
+static auto test_queue_totals()
+{
+	std::string const filename = "test.queue";
+	std::remove(filename.c_str());
+	auto * const totals = static_cast<std::atomic<long> *>(::mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+	auto is_balanced = false;
+	{
+		auto my_queue = locker::queue<int, 16>(filename);
+		pid_t children[8];
+		for(auto i = 0; i < 4; ++i)
+		{
+			children[i] = spawn([&]()
+			{
+				for(auto value = 1; value <= 500; ++value)
+				{
+					my_queue.push(value);
+				}
+			});
+			children[i + 4] = spawn([&]()
+			{
+				for(auto j = 0; j < 500; ++j)
+				{
+					totals[0].fetch_add(my_queue.pop());
+					totals[1].fetch_add(1);
+				}
+			});
+		}
+		for(auto const child : children)
+		{
+			::waitpid(child, nullptr, 0);
+		}
+		is_balanced = totals[0].load() == 4 * 500 * 501 / 2 and totals[1].load() == 4 * 500 and my_queue.size() == 0;
+	}
+	std::cout << "queue " << (is_balanced ? "delivered" : "lost") << " every element pushed by 4 processes to 4 others" << std::endl;
+	::munmap(totals, 4096);
+	std::remove(filename.c_str());
+	return is_balanced;
+}
+
+static auto test_epoch_reclaim()
+{
+	std::string const filename = "test.epoch";
+	remove_shared(filename, ".epoch");
+	auto * const flags = static_cast<std::atomic<int> *>(::mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+	auto & is_inside = flags[0];
+	auto & has_left = flags[1];
+	auto is_deferred = false;
+	{
+		auto my_epoch = locker::epoch(filename);
+		auto const reader = spawn([&]()
+		{
+			auto const section = my_epoch.read();
+			is_inside.store(1);
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+			has_left.store(1);
+		});
+		while(is_inside.load() == 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		my_epoch.retire([&]()
+		{
+			is_deferred = has_left.load() != 0;
+		});
+		my_epoch.reclaim();
+		::waitpid(reader, nullptr, 0);
+		is_inside.store(0);
+		auto const killed = spawn([&]()
+		{
+			auto const section = my_epoch.read();
+			is_inside.store(1);
+			::pause();
+		});
+		while(is_inside.load() == 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		::kill(killed, SIGKILL);
+		::waitpid(killed, nullptr, 0);
+		auto is_freed = false;
+		my_epoch.retire([&]()
+		{
+			is_freed = true;
+		});
+		is_deferred = is_deferred and my_epoch.reclaim() == 1 and is_freed;
+	}
+	std::cout << "epoch " << (is_deferred ? "deferred" : "did not defer") << " reclamation until its readers left or died" << std::endl;
+	::munmap(flags, 4096);
+	remove_shared(filename, ".epoch");
+	return is_deferred;
+}
+
 int main()
 {
 	int data = 0;
@@ -62,7 +431,13 @@ int main()
 			while((pid = wait(&status)) > 0);
 			auto const guard = locker::lock_guard(filename);
 			std::ifstream(filename) >> data;
-			std::cout << (data == NUM_FORKS ? "the test was successful!" : "the test has failed!") << std::endl;
+			auto const is_upgrade_safe = test_shared_upgrade();
+			auto const is_cohort_safe = test_cohort_takeover();
+			auto const is_release_safe = test_release_all();
+			auto const is_keyed_safe = test_keyed_split();
+			auto const is_queue_safe = test_queue_totals();
+			auto const is_epoch_safe = test_epoch_reclaim();
+			std::cout << (data == NUM_FORKS and is_upgrade_safe and is_cohort_safe and is_release_safe and is_keyed_safe and is_queue_safe and is_epoch_safe ? "the test was successful!" : "the test has failed!") << std::endl;
 			return EXIT_SUCCESS;
 		}
 	}